@@ -50,7 +50,8 @@ set(CORE_COMMON_FLAGS
 
 set(CORE_CXX_FLAGS
     ${CORE_COMMON_FLAGS}
-    -std=c++17
+    -std=c++20
+    -Wno-volatile
     -fno-rtti
     -fno-exceptions
     -fpermissive
@@ -31,7 +31,7 @@ set(CORE_COMMON_FLAGS
 
 set(CORE_CXX_FLAGS
     ${CORE_COMMON_FLAGS}
-    -std=c++17
+    -std=c++20
     -fno-rtti
     -fno-exceptions
     -fpermissive
@@ -97,8 +97,4 @@ namespace core::mcu
             }
         }
     }
-
-    inline void idle()
-    {
-    }
 }    // namespace core::mcu
\ No newline at end of file
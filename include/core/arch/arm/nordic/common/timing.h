@@ -23,9 +23,115 @@
 
 #include <drivers/nrfx_common.h>
 #include "nrfx_glue.h"
+#include <hal/nrf_rtc.h>
+#include "nrf_soc.h"
+#include "nrf_sdh.h"
+
+#define CORE_MCU_TIMING_COUNTER_ISR RTC2_IRQHandler
 
 namespace core::mcu::timing
 {
+    constexpr uint32_t TICKS_PER_SECOND = 32768;
+
+    namespace hw
+    {
+        constexpr uint32_t COUNTER_BITS = 24;
+
+        /// RTC0 and RTC1 are used by SoftDevice and app_timer: RTC2 runs from LFCLK
+        /// without prescaler as free-running counter. It keeps running while the CPU sleeps.
+        inline void initCounter()
+        {
+            nrf_rtc_task_trigger(NRF_RTC2, NRF_RTC_TASK_STOP);
+            nrf_rtc_task_trigger(NRF_RTC2, NRF_RTC_TASK_CLEAR);
+            nrf_rtc_prescaler_set(NRF_RTC2, 0);
+            nrf_rtc_task_trigger(NRF_RTC2, NRF_RTC_TASK_START);
+        }
+
+        inline uint32_t counter()
+        {
+            return nrf_rtc_counter_get(NRF_RTC2);
+        }
+
+        /// Counter interrupt is shared by overflow (tickless mode only) and wakeup compare events.
+        inline void enableInterrupt()
+        {
+            // lowest priority available to the application with SoftDevice
+            NVIC_SetPriority(RTC2_IRQn, 7);
+            NVIC_EnableIRQ(RTC2_IRQn);
+        }
+
+        inline void enableOverflowInterrupt()
+        {
+            nrf_rtc_event_clear(NRF_RTC2, NRF_RTC_EVENT_OVERFLOW);
+            nrf_rtc_int_enable(NRF_RTC2, NRF_RTC_INT_OVERFLOW_MASK);
+        }
+
+        inline bool isOverflowPending()
+        {
+            return nrf_rtc_event_check(NRF_RTC2, NRF_RTC_EVENT_OVERFLOW);
+        }
+
+        inline void clearOverflow()
+        {
+            nrf_rtc_event_clear(NRF_RTC2, NRF_RTC_EVENT_OVERFLOW);
+        }
+
+        inline void clearWakeup()
+        {
+            nrf_rtc_event_clear(NRF_RTC2, NRF_RTC_EVENT_COMPARE_0);
+        }
+
+        /// Sleeps until the next interrupt or until maxUs elapses (0: no limit).
+        /// Sleeping is skipped if wakeup has been requested.
+        /// Compare channel 0 is used as wakeup source. SoftDevice calls can't be made with
+        /// interrupts disabled: event register makes sure that the interrupt which occurs
+        /// before the core is put to sleep still wakes it.
+        inline void sleep(uint32_t maxUs, const volatile bool& wakeup)
+        {
+            constexpr uint32_t MAX_TICKS = 1UL << (COUNTER_BITS - 1);
+
+            if (wakeup)
+            {
+                return;
+            }
+
+            if (maxUs)
+            {
+                uint32_t ticks = static_cast<uint64_t>(maxUs) * TICKS_PER_SECOND / 1000000;
+
+                // compare event isn't guaranteed when set less than two ticks ahead
+                if (ticks < 2)
+                {
+                    return;
+                }
+
+                if (ticks > MAX_TICKS)
+                {
+                    ticks = MAX_TICKS;
+                }
+
+                clearWakeup();
+                nrf_rtc_cc_set(NRF_RTC2, 0, (counter() + ticks) & ((1UL << COUNTER_BITS) - 1));
+                nrf_rtc_int_enable(NRF_RTC2, NRF_RTC_INT_COMPARE0_MASK);
+            }
+
+            if (nrf_sdh_is_enabled())
+            {
+                sd_app_evt_wait();
+            }
+            else
+            {
+                // clear the event register in case it was set: second WFE sleeps
+                __WFE();
+                __SEV();
+                __WFE();
+            }
+
+            nrf_rtc_int_disable(NRF_RTC2, NRF_RTC_INT_COMPARE0_MASK);
+            clearWakeup();
+        }
+    }    // namespace hw
+
     inline void waitMs(uint32_t ms)
     {
         while (ms--)
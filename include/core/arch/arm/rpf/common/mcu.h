@@ -109,8 +109,4 @@ namespace core::mcu
             uid[i] = pico_uid.id[i];
         }
     }
-
-    inline void idle()
-    {
-    }
 }    // namespace core::mcu
\ No newline at end of file
@@ -22,9 +22,96 @@
 #pragma once
 
 #include "pico/stdlib.h"
+#include "hardware/structs/timer.h"
+#include "hardware/timer.h"
+#include "core/arch/arm/rpf/common/atomic.h"
 
 namespace core::mcu::timing
 {
+    constexpr uint32_t TICKS_PER_SECOND = 1000000;
+
+    namespace hw
+    {
+        constexpr uint32_t COUNTER_BITS = 64;
+
+        /// 64-bit 1 MHz system timer is always running and never overflows.
+        inline void initCounter()
+        {
+        }
+
+        inline void enableOverflowInterrupt()
+        {
+        }
+
+        /// Counter never overflows, so there is no overflow to account for.
+        inline bool isOverflowPending()
+        {
+            return false;
+        }
+
+        inline void clearOverflow()
+        {
+        }
+
+        /// Raw registers are read since latched TIMELR/TIMEHR pair can't be shared between contexts.
+        inline uint64_t counter()
+        {
+            uint32_t high;
+            uint32_t low;
+
+            do
+            {
+                high = timer_hw->timerawh;
+                low  = timer_hw->timerawl;
+            } while (high != timer_hw->timerawh);
+
+            return (static_cast<uint64_t>(high) << 32) | low;
+        }
+
+        /// Hardware alarm used to wake the core from sleep.
+        inline int wakeupAlarm = -1;
+
+        /// Claims one of the hardware alarms for wakeup: core::mcu::timers skips it.
+        inline void enableInterrupt()
+        {
+            wakeupAlarm = hardware_alarm_claim_unused(false);
+
+            if (wakeupAlarm >= 0)
+            {
+                // the interrupt only needs to wake the core
+                hardware_alarm_set_callback(wakeupAlarm, [](uint) {});
+            }
+        }
+
+        /// Sleeps until the next interrupt or until maxUs elapses (0: no limit).
+        /// Sleeping is skipped if wakeup has been requested.
+        /// Interrupts are disabled while arming so that the ones which occur meanwhile
+        /// still wake the core: they are serviced once the core is awake.
+        inline void sleep(uint32_t maxUs, const volatile bool& wakeup)
+        {
+            CORE_MCU_ATOMIC_SECTION
+            {
+                const bool ARM     = maxUs && (wakeupAlarm >= 0) && !wakeup;
+                bool       expired = wakeup;
+
+                if (ARM)
+                {
+                    expired = hardware_alarm_set_target(wakeupAlarm, make_timeout_time_us(maxUs));
+                }
+
+                if (!expired)
+                {
+                    __wfi();
+                }
+
+                if (ARM)
+                {
+                    hardware_alarm_cancel(wakeupAlarm);
+                }
+            }
+        }
+    }    // namespace hw
+
     inline void waitMs(uint32_t ms)
     {
         sleep_ms(ms);
@@ -0,0 +1,60 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+#include "hal.h"
+
+// Internal
+// STM32F4 CRC unit computes CRC-32/MPEG-2 over 32-bit words, MSB first, always
+// starting from 0xFFFFFFFF. Standard (reflected) CRC-32 is obtained by reversing
+// the bits of each input word and of the result.
+// The unit has no way to restore previous state, so it can only be used when
+// computing CRC from the start of the data, and not from interrupts.
+
+#if defined(STM32F4) && defined(CRC)
+#define CORE_UTIL_CRC32_HW
+
+namespace core::util::crc::hw
+{
+    /// Computes standard CRC-32 over provided amount of whole words.
+    /// returns: CRC-32 register value before final XOR and reflection (same as the
+    ///          running value of the software implementation).
+    inline uint32_t crc32(const uint8_t* data, size_t words)
+    {
+        __HAL_RCC_CRC_CLK_ENABLE();
+        CRC->CR = CRC_CR_RESET;
+
+        for (size_t i = 0; i < words; i++)
+        {
+            uint32_t word;
+            memcpy(&word, &data[i * sizeof(uint32_t)], sizeof(word));
+            CRC->DR = __RBIT(word);
+        }
+
+        return __RBIT(CRC->DR);
+    }
+}    // namespace core::util::crc::hw
+#endif
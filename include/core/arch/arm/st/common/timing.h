@@ -22,9 +22,108 @@
 #pragma once
 
 #include "hal.h"
+#include "core/arch/arm/common/atomic.h"
+
+#define CORE_MCU_TIMING_COUNTER_ISR TIM5_IRQHandler
 
 namespace core::mcu::timing
 {
+    constexpr uint32_t TICKS_PER_SECOND = 1000000;
+
+    namespace hw
+    {
+        constexpr uint32_t COUNTER_BITS = 32;
+
+        /// TIM5 is 32-bit on all supported F4 MCUs and isn't used by core::mcu::timers:
+        /// it is used as free-running counter with 1 MHz tick.
+        inline void initCounter()
+        {
+            __HAL_RCC_TIM5_CLK_ENABLE();
+
+            // timers on APB1 run at twice the bus clock when APB1 prescaler isn't 1
+            uint32_t clock = HAL_RCC_GetPCLK1Freq();
+
+            if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+            {
+                clock *= 2;
+            }
+
+            TIM5->CR1 = 0;
+            TIM5->PSC = (clock / TICKS_PER_SECOND) - 1;
+            TIM5->ARR = 0xFFFFFFFF;
+            TIM5->CNT = 0;
+            TIM5->EGR = TIM_EGR_UG;    // load the prescaler
+            TIM5->CR1 = TIM_CR1_CEN;
+        }
+
+        inline uint32_t counter()
+        {
+            return TIM5->CNT;
+        }
+
+        /// Counter interrupt is shared by overflow (tickless mode only) and wakeup compare events.
+        inline void enableInterrupt()
+        {
+            HAL_NVIC_SetPriority(TIM5_IRQn, 0, 0);
+            HAL_NVIC_EnableIRQ(TIM5_IRQn);
+        }
+
+        inline void enableOverflowInterrupt()
+        {
+            TIM5->SR = ~TIM_SR_UIF;
+            TIM5->DIER |= TIM_DIER_UIE;
+        }
+
+        inline bool isOverflowPending()
+        {
+            return TIM5->SR & TIM_SR_UIF;
+        }
+
+        inline void clearOverflow()
+        {
+            TIM5->SR = ~TIM_SR_UIF;
+        }
+
+        inline void clearWakeup()
+        {
+            TIM5->SR = ~TIM_SR_CC1IF;
+        }
+
+        /// Sleeps until the next interrupt or until maxUs elapses (0: no limit).
+        /// Sleeping is skipped if wakeup has been requested.
+        /// Compare channel 1 is used as wakeup source. Interrupts are disabled while
+        /// arming so that the ones which occur meanwhile still wake the core: they are
+        /// serviced once the core is awake.
+        inline void sleep(uint32_t maxUs, const volatile bool& wakeup)
+        {
+            CORE_MCU_ATOMIC_SECTION
+            {
+                bool expired = wakeup;
+
+                if (maxUs && !expired)
+                {
+                    const uint32_t TARGET = TIM5->CNT + maxUs;
+
+                    TIM5->CCR1 = TARGET;
+                    TIM5->SR   = ~TIM_SR_CC1IF;
+                    TIM5->DIER |= TIM_DIER_CC1IE;
+
+                    // compare event is generated only on exact match: check whether the
+                    // counter has passed the target before the channel was armed
+                    expired = (static_cast<int32_t>(TIM5->CNT - TARGET) >= 0) && !(TIM5->SR & TIM_SR_CC1IF);
+                }
+
+                if (!expired)
+                {
+                    __WFI();
+                }
+
+                TIM5->DIER &= ~TIM_DIER_CC1IE;
+                clearWakeup();
+            }
+        }
+    }    // namespace hw
+
     inline void waitMs(uint32_t ms)
     {
         HAL_Delay(ms);
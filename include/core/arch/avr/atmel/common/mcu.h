@@ -268,10 +268,6 @@ namespace core::mcu
             ;
         }
     }
-
-    inline void idle()
-    {
-    }
 }    // namespace core::mcu
 
 #if defined(__AVR_ATmega16U2__) || defined(__AVR_ATmega8U2__) || defined(__AVR_ATmega32U4__) || defined(__AVR_AT90USB1286__)
@@ -21,10 +21,60 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include <util/delay.h>
 
 namespace core::mcu::timing
 {
+    // prescaler 64, see core::mcu::timers
+    constexpr uint32_t TICKS_PER_SECOND = F_CPU / 64;
+
+    namespace hw
+    {
+        /// No free-running counter is available: counter of the timer used for millisecond
+        /// interrupt is used instead, which counts up to the compare value and restarts.
+        inline uint16_t counter(size_t timerIndex)
+        {
+            return timerIndex ? TCNT1 : TCNT0;
+        }
+
+        /// Checks whether the counter has restarted without the interrupt being serviced yet.
+        inline bool isPeriodPending(size_t timerIndex)
+        {
+            return timerIndex ? (TIFR1 & (1 << OCF1A)) : (TIFR0 & (1 << OCF0A));
+        }
+
+        /// Sleeps until the next interrupt. No dedicated wakeup source is used: millisecond
+        /// interrupt wakes the core, so sleeping is skipped when maxUs is shorter than that.
+        /// Sleeping is also skipped if wakeup has been requested.
+        /// Interrupts are enabled right before entering the sleep mode: the instruction after
+        /// sei is always executed, so that no interrupt is serviced before sleeping.
+        inline void sleep(uint32_t maxUs, const volatile bool& wakeup)
+        {
+            if (maxUs && (maxUs < 1000))
+            {
+                return;
+            }
+
+            set_sleep_mode(SLEEP_MODE_IDLE);
+            cli();
+
+            if (wakeup)
+            {
+                sei();
+                return;
+            }
+
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+    }    // namespace hw
+
     inline void waitMs(uint32_t ms)
     {
         while (ms--)
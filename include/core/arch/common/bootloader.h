@@ -31,6 +31,14 @@ namespace core::mcu::bootloader
     bool erasePage(size_t index);
     bool fillPage(size_t index, uint32_t addressInPage, uint32_t data);
     bool commitPage(size_t index);
+
+    /// Enables or disables differential update mode.
+    /// In this mode, pages whose contents match the incoming data are neither erased nor programmed.
+    /// Resets the amount of skipped pages.
+    void setDifferentialMode(bool state);
+
+    /// Returns the amount of pages skipped in differential update mode.
+    size_t skippedPages();
 }    // namespace core::mcu::bootloader
 
 #else
@@ -21,19 +21,17 @@
 
 #pragma once
 
-#ifndef CORE_MCU_STUB
-
 #include <inttypes.h>
 #include <cstddef>
 
 // Internal
-// Use cache to avoid writing to flash for each word. Instead, use buffer and write it out once it's full.
+// Use cache to avoid writing to flash for each word. Instead, collect the words in one buffer while
+// the previously filled one is written to flash in chunks.
 
 namespace core::mcu::bootloader
 {
     void resetCache();
+    bool eraseCachedPage(size_t index);
     void fillCache(size_t index, uint32_t addressInPage, uint32_t data);
     void flushCache(size_t index);
-}    // namespace core::mcu::bootloader
-
-#endif
\ No newline at end of file
+}    // namespace core::mcu::bootloader
\ No newline at end of file
@@ -0,0 +1,186 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "core/arch/common/bootloader.h"
+#include "core/arch/common/flash.h"
+#include "core/util/lz.h"
+
+// Architecture-independent helpers used to write continuous firmware stream
+// through the bootloader page API.
+
+namespace core::mcu::bootloader
+{
+    /// Writes continuous stream of firmware data starting at provided page.
+    /// Pages are erased once the first word for them arrives and committed once
+    /// they are full, so the data can be provided in blocks of any size.
+    class StreamWriter
+    {
+        public:
+        explicit StreamWriter(size_t firstPage)
+            : _firstPage(firstPage)
+        {
+            reset();
+        }
+
+        bool write(const uint8_t* data, size_t size)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                _word |= static_cast<uint32_t>(data[i]) << (_wordBytes * 8);
+
+                if (++_wordBytes == sizeof(uint32_t))
+                {
+                    if (!writeWord())
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        /// Writes any incomplete word padded with 0xFF and commits the last page.
+        bool finish()
+        {
+            if (_wordBytes)
+            {
+                for (; _wordBytes < sizeof(uint32_t); _wordBytes++)
+                {
+                    _word |= static_cast<uint32_t>(0xFF) << (_wordBytes * 8);
+                }
+
+                if (!writeWord())
+                {
+                    return false;
+                }
+            }
+
+            if (_pageOffset)
+            {
+                _pageOffset = 0;
+                return commitPage(_page++);
+            }
+
+            return true;
+        }
+
+        void reset()
+        {
+            _page       = _firstPage;
+            _pageOffset = 0;
+            _word       = 0;
+            _wordBytes  = 0;
+        }
+
+        /// Returns the amount of pages which have been written entirely.
+        size_t pages() const
+        {
+            return _page - _firstPage;
+        }
+
+        private:
+        const size_t _firstPage;
+        size_t       _page       = 0;
+        uint32_t     _pageOffset = 0;
+        uint32_t     _word       = 0;
+        uint8_t      _wordBytes  = 0;
+
+        bool writeWord()
+        {
+            if (!_pageOffset && !erasePage(_page))
+            {
+                return false;
+            }
+
+            if (!fillPage(_page, _pageOffset, _word))
+            {
+                return false;
+            }
+
+            _word      = 0;
+            _wordBytes = 0;
+            _pageOffset += sizeof(uint32_t);
+
+            if (_pageOffset == core::mcu::flash::pageSize(_page))
+            {
+                _pageOffset = 0;
+                return commitPage(_page++);
+            }
+
+            return true;
+        }
+    };
+
+    /// Decompresses firmware stream produced by core::util::lz::Encoder (core/util/lz_encoder.h)
+    /// straight into flash pages: only the decoder window is kept in RAM, never the full image.
+    template<size_t windowSize>
+    class CompressedStreamWriter
+    {
+        public:
+        explicit CompressedStreamWriter(size_t firstPage)
+            : _writer(firstPage)
+        {}
+
+        /// Decompresses and writes provided block of compressed data.
+        /// returns: False if the stream is corrupted or if writing has failed, true otherwise.
+        bool write(const uint8_t* data, size_t size)
+        {
+            return _decoder.decode(data, size, [this](const uint8_t* decoded, size_t decodedSize)
+                                   {
+                                       return _writer.write(decoded, decodedSize);
+                                   });
+        }
+
+        /// Verifies that the entire stream has been decoded (length and CRC from the stream
+        /// match) and commits the last page.
+        bool finish()
+        {
+            if (!_decoder.isComplete())
+            {
+                return false;
+            }
+
+            return _writer.finish();
+        }
+
+        void reset()
+        {
+            _decoder.reset();
+            _writer.reset();
+        }
+
+        /// Returns the total amount of decompressed bytes.
+        uint32_t total() const
+        {
+            return _decoder.total();
+        }
+
+        private:
+        core::util::lz::Decoder<windowSize> _decoder;
+        StreamWriter                        _writer;
+    };
+}    // namespace core::mcu::bootloader
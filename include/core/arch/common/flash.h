@@ -28,6 +28,11 @@
 #include "core/error_handler.h"
 #include <core_mcu_generated.h>
 
+#ifdef CORE_MCU_VENDOR_NORDIC
+#define CORE_MCU_FLASH_ASYNC
+#include "core/arch/common/flash_async.h"
+#endif
+
 extern uint32_t __flash_start__[];
 
 namespace core::mcu::flash
@@ -50,9 +55,50 @@ namespace core::mcu::flash
 
     bool erasePage(size_t index);
     bool write32(uint32_t address, uint32_t data);
+
+    /// Writes block of data to flash.
+    /// Address and size need to be 4-byte aligned.
+    /// Depending on the MCU, written data can be cached in RAM: flush needs to be called
+    /// once all the data has been written.
+    bool write(uint32_t address, const uint8_t* data, size_t size);
+
+    /// Writes any data cached by write/write32 to flash.
+    bool flush();
+
     bool read8(uint32_t address, uint8_t& data);
     bool read16(uint32_t address, uint16_t& data);
     bool read32(uint32_t address, uint32_t& data);
+
+    /// Reads block of data from flash.
+    bool read(uint32_t address, uint8_t* data, size_t size);
+
+#ifdef CORE_MCU_VENDOR_NORDIC
+
+    // Asynchronous operations: available on MCUs on which flash operations are scheduled
+    // by other firmware (SoftDevice on nRF52), indicated by CORE_MCU_FLASH_ASYNC.
+    namespace async
+    {
+        /// Queues erase of the page.
+        /// returns: False if the queue is full, true otherwise.
+        bool erasePage(size_t index, callback_t callback = nullptr, void* context = nullptr);
+
+        /// Queues write of block of data.
+        /// Address, size and data pointer need to be 4-byte aligned. Data needs to remain
+        /// valid until the operation is completed.
+        /// returns: False if the queue is full or if the request is invalid, true otherwise.
+        bool write(uint32_t address, const uint8_t* data, size_t size, callback_t callback = nullptr, void* context = nullptr);
+
+        /// Calls the callbacks of finished operations: needs to be called periodically
+        /// from the main loop.
+        void update();
+
+        /// Returns the amount of queued operations whose callbacks haven't been called yet.
+        size_t pending();
+
+        /// Checks whether any flash operation is in progress.
+        bool isBusy();
+    }    // namespace async
+#endif
 }    // namespace core::mcu::flash
 
 #else
@@ -0,0 +1,211 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#ifdef CORE_MCU_STUB
+#include "core/arch/stub/atomic.h"
+#else
+#include "core/arch/arm/common/atomic.h"
+#endif
+
+// Internal
+// Architecture-independent queue of asynchronous flash operations. Only single
+// operation is handed to the driver at a time: once it completes, the next one
+// is started right away, while the completion callbacks are dispatched later
+// from the main loop.
+
+namespace core::mcu::flash::async
+{
+    /// Called once the operation has been completed.
+    /// param [in]: context     Context pointer provided when queueing the operation.
+    /// param [in]: success     Whether the operation has succeeded.
+    using callback_t = void (*)(void* context, bool success);
+
+    enum class operation_t : uint8_t
+    {
+        ERASE,
+        WRITE,
+    };
+
+    struct Request
+    {
+        operation_t    operation = operation_t::ERASE;
+        uint32_t       address   = 0;    ///< Page index for erase.
+        const uint8_t* data      = nullptr;
+        size_t         size      = 0;
+        callback_t     callback  = nullptr;
+        void*          context   = nullptr;
+        bool           success   = false;
+    };
+
+    /// Driver needs to provide bool start(const Request&), which starts the operation
+    /// without waiting for it to finish. Once finished, driver needs to call complete(),
+    /// which is also allowed from interrupt context. All the other functions need to be
+    /// called from the main loop.
+    template<size_t depth, typename Driver>
+    class Queue
+    {
+        public:
+        explicit Queue(Driver& driver)
+            : _driver(driver)
+        {}
+
+        /// Adds the request to the queue and starts it if no other operation is in progress.
+        /// returns: False if the queue is full, true otherwise.
+        bool push(const Request& request)
+        {
+            bool queued = false;
+            bool start  = false;
+
+            CORE_MCU_ATOMIC_SECTION
+            {
+                if ((_head - _tail) < depth)
+                {
+                    _requests[_head++ % depth] = request;
+                    start                      = !_inFlight;
+                    _inFlight                  = true;
+                    queued                     = true;
+                }
+            }
+
+            if (!queued)
+            {
+                return false;
+            }
+
+            if (start)
+            {
+                startNext();
+            }
+
+            return true;
+        }
+
+        /// Marks the operation in progress as finished and starts the next one, if any.
+        void complete(bool success)
+        {
+            bool start = false;
+
+            CORE_MCU_ATOMIC_SECTION
+            {
+                if (_inFlight)
+                {
+                    _requests[_active++ % depth].success = success;
+                    _inFlight                            = _active != _head;
+                    start                                = _inFlight;
+                }
+            }
+
+            if (start)
+            {
+                startNext();
+            }
+        }
+
+        /// Calls the callbacks of all finished operations.
+        void update()
+        {
+            while (true)
+            {
+                Request request;
+                bool    finished = false;
+
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    finished = _tail != _active;
+
+                    if (finished)
+                    {
+                        request = _requests[_tail++ % depth];
+                    }
+                }
+
+                if (!finished)
+                {
+                    break;
+                }
+
+                if (request.callback != nullptr)
+                {
+                    request.callback(request.context, request.success);
+                }
+            }
+        }
+
+        /// Returns the request which is currently in progress.
+        const Request& active() const
+        {
+            return _requests[_active % depth];
+        }
+
+        /// Returns the amount of operations whose callbacks haven't been called yet.
+        size_t pending() const
+        {
+            size_t count = 0;
+
+            CORE_MCU_ATOMIC_SECTION
+            {
+                count = _head - _tail;
+            }
+
+            return count;
+        }
+
+        bool isBusy() const
+        {
+            return _inFlight;
+        }
+
+        private:
+        Driver&       _driver;
+        Request       _requests[depth] = {};
+        size_t        _head            = 0;    ///< Next free slot.
+        size_t        _active          = 0;    ///< Operation in progress.
+        size_t        _tail            = 0;    ///< Next operation whose callback needs to be called.
+        volatile bool _inFlight        = false;
+
+        void startNext()
+        {
+            // operations which can't be started are completed right away
+            while (!_driver.start(active()))
+            {
+                bool next = false;
+
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    _requests[_active++ % depth].success = false;
+                    _inFlight                            = _active != _head;
+                    next                                 = _inFlight;
+                }
+
+                if (!next)
+                {
+                    break;
+                }
+            }
+        }
+    };
+}    // namespace core::mcu::flash::async
@@ -0,0 +1,252 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+// Internal
+// Architecture-independent write-back cache for flash which is programmed in small pages
+// but erased in larger sectors, such as external QSPI flash on RP2040. Writes are collected
+// in RAM and each modified page is programmed once, either on explicit flush or once
+// the write moves on to another sector. Flash access is abstracted through Driver type
+// so that the same logic can run against simulated flash on stub MCU.
+//
+// Driver needs to provide the following (offsets are relative to flash start address):
+//  void read(uint32_t offset, uint8_t* data, size_t size);
+//  void erase(uint32_t offset, size_t size);
+//  void program(uint32_t offset, const uint8_t* data, size_t size);
+
+namespace core::mcu::flash
+{
+    template<size_t pageSize, size_t sectorSize, typename Driver>
+    class PageCache
+    {
+        static_assert(sectorSize % pageSize == 0, "Sector size needs to be multiple of page size");
+        static_assert(sectorSize / pageSize <= 32, "Too many pages in sector");
+
+        public:
+        PageCache(Driver& driver)
+            : _driver(driver)
+        {}
+
+        /// Writes data to cache.
+        /// Sector in which the data resides is loaded first if needed and previously cached
+        /// sector is flushed.
+        /// param [in]: offset  Offset from flash start address.
+        /// param [in]: data    Pointer to data to write.
+        /// param [in]: size    Amount of bytes to write.
+        void write(uint32_t offset, const uint8_t* data, size_t size)
+        {
+            while (size)
+            {
+                const uint32_t INDEX_IN_SECTOR = offset % sectorSize;
+                size_t         chunk           = sectorSize - INDEX_IN_SECTOR;
+
+                if (chunk > size)
+                {
+                    chunk = size;
+                }
+
+                load(offset / sectorSize);
+
+                for (size_t i = 0; i < chunk; i++)
+                {
+                    auto& cached = _buffer[INDEX_IN_SECTOR + i];
+
+                    if (cached == data[i])
+                    {
+                        // same value - skip
+                        continue;
+                    }
+
+                    // Erasing a sector takes a long time (~45ms on RP2040) - do it only if needed:
+                    // location which isn't erased (value 0xFF) can't be reprogrammed.
+                    if (cached != 0xFF)
+                    {
+                        _erase = true;
+                    }
+
+                    cached = data[i];
+                    _dirtyPages |= 1UL << ((INDEX_IN_SECTOR + i) / pageSize);
+                }
+
+                offset += chunk;
+                data += chunk;
+                size -= chunk;
+            }
+        }
+
+        /// Reads data from flash, taking into account the data which hasn't been flushed yet.
+        /// param [in]: offset  Offset from flash start address.
+        /// param [in]: data    Pointer to array in which read data will be stored.
+        /// param [in]: size    Amount of bytes to read.
+        void read(uint32_t offset, uint8_t* data, size_t size)
+        {
+            while (size)
+            {
+                const uint32_t INDEX_IN_SECTOR = offset % sectorSize;
+                size_t         chunk           = sectorSize - INDEX_IN_SECTOR;
+
+                if (chunk > size)
+                {
+                    chunk = size;
+                }
+
+                if ((offset / sectorSize) == _sector)
+                {
+                    memcpy(data, &_buffer[INDEX_IN_SECTOR], chunk);
+                }
+                else
+                {
+                    _driver.read(offset, data, chunk);
+                }
+
+                offset += chunk;
+                data += chunk;
+                size -= chunk;
+            }
+        }
+
+        /// Programs all the modified pages of currently cached sector.
+        void flush()
+        {
+            if (!_dirtyPages)
+            {
+                return;
+            }
+
+            const uint32_t START = _sector * sectorSize;
+
+            if (_erase)
+            {
+                _driver.erase(START, sectorSize);
+
+                // all the pages are blank now - write back those which hold any data
+                uint32_t pages = 0;
+
+                for (size_t page = 0; page < PAGES; page++)
+                {
+                    if (!isBlank(page))
+                    {
+                        pages |= 1UL << page;
+                    }
+                }
+
+                program(pages);
+            }
+            else
+            {
+                program(_dirtyPages);
+            }
+
+            _dirtyPages = 0;
+            _erase      = false;
+        }
+
+        /// Drops cached sector if it overlaps with specified range.
+        /// Used once the range has been erased directly.
+        /// param [in]: offset  Offset from flash start address.
+        /// param [in]: size    Size of the erased range in bytes.
+        void invalidate(uint32_t offset, size_t size)
+        {
+            if (_sector == NO_SECTOR)
+            {
+                return;
+            }
+
+            const uint32_t START = _sector * sectorSize;
+
+            if ((START < (offset + size)) && (offset < (START + sectorSize)))
+            {
+                _sector     = NO_SECTOR;
+                _dirtyPages = 0;
+                _erase      = false;
+            }
+        }
+
+        private:
+        static constexpr uint32_t NO_SECTOR = 0xFFFFFFFF;
+        static constexpr size_t   PAGES     = sectorSize / pageSize;
+
+        Driver&  _driver;
+        uint8_t  _buffer[sectorSize] = {};
+        uint32_t _sector             = NO_SECTOR;
+        uint32_t _dirtyPages         = 0;
+        bool     _erase              = false;
+
+        void load(uint32_t sector)
+        {
+            if (_sector == sector)
+            {
+                return;
+            }
+
+            flush();
+            _driver.read(sector * sectorSize, _buffer, sectorSize);
+            _sector = sector;
+        }
+
+        bool isBlank(size_t page)
+        {
+            for (size_t i = page * pageSize; i < (page + 1) * pageSize; i++)
+            {
+                if (_buffer[i] != 0xFF)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// Programs specified pages, merging adjacent ones into single operation.
+        void program(uint32_t pages)
+        {
+            size_t page = 0;
+
+            while (page < PAGES)
+            {
+                if (!(pages & (1UL << page)))
+                {
+                    page++;
+                    continue;
+                }
+
+                size_t last = page;
+
+                while (((last + 1) < PAGES) && (pages & (1UL << (last + 1))))
+                {
+                    last++;
+                }
+
+                _driver.program(_sector * sectorSize + page * pageSize,
+                                &_buffer[page * pageSize],
+                                (last - page + 1) * pageSize);
+
+                page = last + 1;
+            }
+        }
+    };
+}    // namespace core::mcu::flash
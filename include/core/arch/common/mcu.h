@@ -37,6 +37,17 @@ namespace core::mcu
         APP,
         BOOT
     };
+
+    /// Puts the core to sleep until the next interrupt occurs, but for no longer than maxUs.
+    /// With maxUs set to 0, only an interrupt wakes the core. Time spent asleep is accounted
+    /// in core::mcu::timing::idleUs().
+    void idle(uint32_t maxUs = 0);
+
+    /// Makes the ongoing or the next call to idle() return without sleeping.
+    /// Used to signal the work posted from interrupt context to the main loop: calling it
+    /// from interrupt covers the case when the interrupt fires after the main loop has
+    /// checked for work, but before the core was put to sleep.
+    void wake();
 }    // namespace core::mcu
 
 #else
@@ -0,0 +1,497 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "core/arch/common/timers.h"
+#include "core/arch/common/timing.h"
+
+#ifdef CORE_MCU_STUB
+#include "core/arch/stub/atomic.h"
+#elif defined(CORE_MCU_ARCH_AVR)
+#include "core/arch/avr/common/atomic.h"
+#else
+#include "core/arch/arm/common/atomic.h"
+#endif
+
+// Multiplexes any amount of periodic and one-shot virtual timers onto a single hardware
+// timer using hierarchical timing wheel: timers are hashed into slots of the lowest level
+// which covers their deadline, and are moved to the lower levels as the time approaches.
+// Starting and stopping timers is O(1). Hardware timer is programmed to fire only when
+// something needs to be done: either when a timer expires or when the timers from a
+// higher level need to be moved.
+
+namespace core::mcu::timers
+{
+    /// Driver needs to provide:
+    /// uint32_t now():               Current time in wheel ticks. Expected to wrap around at 32 bits.
+    /// void schedule(uint32_t ticks): Arms the hardware to call update() after the specified amount of ticks.
+    /// void cancel():                Disarms the hardware.
+    template<typename Driver>
+    class Wheel
+    {
+        public:
+        /// Called from the context in which update() is called, usually interrupt.
+        using callback_t = void (*)(void* context);
+
+        class Timer
+        {
+            public:
+            Timer(callback_t callback, void* context = nullptr)
+                : _callback(callback)
+                , _context(context)
+            {}
+
+            Timer(const Timer&)            = delete;
+            Timer& operator=(const Timer&) = delete;
+
+            bool isActive() const
+            {
+                return _active;
+            }
+
+            private:
+            friend class Wheel;
+
+            callback_t _callback;
+            void*      _context;
+            Timer*     _next    = nullptr;
+            Timer*     _prev    = nullptr;
+            uint32_t   _expires = 0;
+            uint32_t   _period  = 0;
+            uint8_t    _level   = 0;
+            uint8_t    _slot    = 0;
+            bool       _active  = false;
+        };
+
+        static constexpr size_t   SLOT_BITS = 5;
+        static constexpr size_t   SLOTS     = 1 << SLOT_BITS;
+        static constexpr size_t   LEVELS    = 5;
+        static constexpr uint32_t MAX_DELAY = (static_cast<uint32_t>(1) << (SLOT_BITS * LEVELS)) - 1;
+
+        explicit Wheel(Driver& driver)
+            : _driver(driver)
+            , _current(driver.now())
+        {}
+
+        /// Starts the timer, or restarts it if already running.
+        /// param [in]: timer   Timer to start. Needs to remain valid while active.
+        /// param [in]: delay   Amount of ticks after which the timer expires.
+        /// param [in]: period  Amount of ticks between expirations after the first one. One-shot if 0.
+        void start(Timer& timer, uint32_t delay, uint32_t period = 0)
+        {
+            CORE_MCU_ATOMIC_SECTION
+            {
+                if (timer._active)
+                {
+                    unlink(timer);
+                }
+
+                const uint32_t NOW = _driver.now();
+
+                // nothing to catch up with
+                if (isEmpty())
+                {
+                    _current = NOW;
+                }
+
+                timer._expires = NOW + delay;
+                timer._period  = period;
+                insert(timer);
+                reprogram();
+            }
+        }
+
+        void stop(Timer& timer)
+        {
+            CORE_MCU_ATOMIC_SECTION
+            {
+                if (timer._active)
+                {
+                    unlink(timer);
+
+                    if (isEmpty())
+                    {
+                        _driver.cancel();
+                    }
+                }
+            }
+        }
+
+        /// Calls the callbacks of expired timers and programs the hardware for the next event.
+        /// Needs to be called once the time specified with Driver::schedule elapses.
+        void update()
+        {
+            const uint32_t NOW = _driver.now();
+            _now               = NOW;
+
+            while (true)
+            {
+                uint32_t delta = 0;
+                bool     event = false;
+
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    event = nextEvent(delta) && (delta <= (NOW - _current)) && (static_cast<int32_t>(NOW - _current) >= 0);
+
+                    if (event)
+                    {
+                        _current += delta;
+                        cascade();
+
+                        // timers started from the callbacks with zero delay expire on the next tick
+                        _expiring = _slots[0][_current & (SLOTS - 1)];
+                        detach(0, _current & (SLOTS - 1));
+                        _current++;
+                    }
+                    else if (static_cast<int32_t>(NOW - _current) >= 0)
+                    {
+                        _current = NOW + 1;
+                    }
+                }
+
+                if (!event)
+                {
+                    break;
+                }
+
+                fire();
+            }
+
+            CORE_MCU_ATOMIC_SECTION
+            {
+                reprogram();
+            }
+        }
+
+        /// Returns the amount of ticks until the next event which requires update() to be called.
+        /// returns: False if no timer is active, true otherwise.
+        bool nextDeadline(uint32_t& ticks) const
+        {
+            bool result = false;
+
+            CORE_MCU_ATOMIC_SECTION
+            {
+                uint32_t delta = 0;
+                result         = nextEvent(delta);
+
+                if (result)
+                {
+                    const uint32_t NOW    = _driver.now();
+                    const uint32_t TARGET = _current + delta;
+
+                    ticks = (static_cast<int32_t>(TARGET - NOW) > 0) ? TARGET - NOW : 0;
+                }
+            }
+
+            return result;
+        }
+
+        private:
+        Driver&  _driver;
+        uint32_t _current;    ///< Next tick to process.
+        uint32_t _now = 0;    ///< Time at which update() has been called.
+        Timer*   _slots[LEVELS][SLOTS] = {};
+        uint32_t _occupied[LEVELS]     = {};
+        Timer*   _expiring             = nullptr;
+
+        bool isEmpty() const
+        {
+            for (size_t level = 0; level < LEVELS; level++)
+            {
+                if (_occupied[level])
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void insert(Timer& timer)
+        {
+            uint32_t delay = timer._expires - _current;
+
+            if (static_cast<int32_t>(delay) < 0)
+            {
+                delay = 0;
+            }
+            else if (delay > MAX_DELAY)
+            {
+                // moved down and re-inserted with the actual deadline once the end of the range is reached
+                delay = MAX_DELAY;
+            }
+
+            size_t level = 0;
+
+            while ((delay >> (SLOT_BITS * (level + 1))) && (level < (LEVELS - 1)))
+            {
+                level++;
+            }
+
+            const uint8_t SLOT = ((_current + delay) >> (SLOT_BITS * level)) & (SLOTS - 1);
+
+            timer._level  = level;
+            timer._slot   = SLOT;
+            timer._prev   = nullptr;
+            timer._next   = _slots[level][SLOT];
+            timer._active = true;
+
+            if (timer._next != nullptr)
+            {
+                timer._next->_prev = &timer;
+            }
+
+            _slots[level][SLOT] = &timer;
+            _occupied[level] |= static_cast<uint32_t>(1) << SLOT;
+        }
+
+        void unlink(Timer& timer)
+        {
+            if (timer._prev != nullptr)
+            {
+                timer._prev->_next = timer._next;
+            }
+            else if (_expiring == &timer)
+            {
+                _expiring = timer._next;
+            }
+            else
+            {
+                _slots[timer._level][timer._slot] = timer._next;
+
+                if (timer._next == nullptr)
+                {
+                    _occupied[timer._level] &= ~(static_cast<uint32_t>(1) << timer._slot);
+                }
+            }
+
+            if (timer._next != nullptr)
+            {
+                timer._next->_prev = timer._prev;
+            }
+
+            timer._active = false;
+        }
+
+        /// Removes all the timers from the slot: list remains linked.
+        void detach(size_t level, size_t slot)
+        {
+            _slots[level][slot] = nullptr;
+            _occupied[level] &= ~(static_cast<uint32_t>(1) << slot);
+        }
+
+        /// Moves the timers from the higher levels whose slot is reached at current tick.
+        void cascade()
+        {
+            for (size_t level = LEVELS - 1; level > 0; level--)
+            {
+                const uint32_t SHIFT = SLOT_BITS * level;
+
+                if (_current & ((static_cast<uint32_t>(1) << SHIFT) - 1))
+                {
+                    continue;
+                }
+
+                const size_t SLOT  = (_current >> SHIFT) & (SLOTS - 1);
+                Timer*       timer = _slots[level][SLOT];
+
+                detach(level, SLOT);
+
+                while (timer != nullptr)
+                {
+                    Timer* next = timer->_next;
+                    insert(*timer);
+                    timer = next;
+                }
+            }
+        }
+
+        /// Calls the callbacks of the timers detached from the expiring slot.
+        /// Interrupts are enabled while the callbacks are running, so they can start and stop timers.
+        void fire()
+        {
+            while (true)
+            {
+                callback_t callback = nullptr;
+                void*      context  = nullptr;
+                bool       pending  = false;
+
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    Timer* timer = _expiring;
+                    pending      = timer != nullptr;
+
+                    if (pending)
+                    {
+                        _expiring = timer->_next;
+
+                        if (_expiring != nullptr)
+                        {
+                            _expiring->_prev = nullptr;
+                        }
+
+                        timer->_active = false;
+                        callback       = timer->_callback;
+                        context        = timer->_context;
+
+                        if (timer->_period)
+                        {
+                            timer->_expires += timer->_period;
+
+                            // skip the missed periods instead of firing them back to back
+                            if (static_cast<int32_t>(timer->_expires - _now) <= 0)
+                            {
+                                timer->_expires += ((_now - timer->_expires) / timer->_period + 1) * timer->_period;
+                            }
+
+                            insert(*timer);
+                        }
+                    }
+                }
+
+                if (!pending)
+                {
+                    break;
+                }
+
+                if (callback != nullptr)
+                {
+                    callback(context);
+                }
+            }
+        }
+
+        static uint32_t rotateRight(uint32_t value, uint32_t amount)
+        {
+            amount &= 31;
+            return amount ? (value >> amount) | (value << (32 - amount)) : value;
+        }
+
+        static uint32_t firstSet(uint32_t value)
+        {
+            return __builtin_ctz(value);
+        }
+
+        /// Finds the amount of ticks from the current tick until the next tick at which
+        /// either a timer expires or timers from a higher level need to be moved down.
+        bool nextEvent(uint32_t& delta) const
+        {
+            bool found = false;
+
+            for (size_t level = 0; level < LEVELS; level++)
+            {
+                if (!_occupied[level])
+                {
+                    continue;
+                }
+
+                const uint32_t SHIFT = SLOT_BITS * level;
+
+                // first slot boundary at or after the current tick
+                const uint32_t POSITION  = (_current + ((static_cast<uint32_t>(1) << SHIFT) - 1)) >> SHIFT;
+                const uint32_t DISTANCE  = firstSet(rotateRight(_occupied[level], POSITION & (SLOTS - 1)));
+                const uint32_t CANDIDATE = ((POSITION + DISTANCE) << SHIFT) - _current;
+
+                if (!found || (CANDIDATE < delta))
+                {
+                    delta = CANDIDATE;
+                    found = true;
+                }
+            }
+
+            return found;
+        }
+
+        void reprogram()
+        {
+            uint32_t delta = 0;
+
+            if (!nextEvent(delta))
+            {
+                _driver.cancel();
+                return;
+            }
+
+            const uint32_t NOW    = _driver.now();
+            const uint32_t TARGET = _current + delta;
+            const uint32_t DELAY  = (static_cast<int32_t>(TARGET - NOW) > 0) ? TARGET - NOW : 1;
+
+            _driver.schedule(DELAY);
+        }
+    };
+
+    /// Wheel driver which uses one of the timers from core::mcu::timers with core::mcu::timing::ticks
+    /// as time base. Hardware timer is restarted with new period for each event: periods longer than
+    /// maxPeriodUs (hardware limit) are split into several events.
+    /// param [in]: tickUs      Duration of single wheel tick in microseconds.
+    /// param [in]: maxPeriodUs Longest period supported by the hardware timer.
+    template<uint32_t tickUs, uint32_t maxPeriodUs>
+    class HwTimerDriver
+    {
+        public:
+        /// Allocates the hardware timer.
+        /// param [in]: handler Handler which needs to call Wheel::update.
+        bool init(handler_t handler)
+        {
+            return allocate(_index, handler);
+        }
+
+        uint32_t now()
+        {
+            // reduced so that the intermediate result doesn't overflow
+            constexpr uint64_t DIVISOR    = gcd(1000000, static_cast<uint64_t>(core::mcu::timing::TICKS_PER_SECOND) * tickUs);
+            constexpr uint64_t MULTIPLIER = 1000000 / DIVISOR;
+            constexpr uint64_t TICKS      = static_cast<uint64_t>(core::mcu::timing::TICKS_PER_SECOND) * tickUs / DIVISOR;
+
+            return core::mcu::timing::ticks() * MULTIPLIER / TICKS;
+        }
+
+        void schedule(uint32_t ticks)
+        {
+            uint64_t us = static_cast<uint64_t>(ticks) * tickUs;
+
+            if (us > maxPeriodUs)
+            {
+                us = maxPeriodUs;
+            }
+
+            setPeriod(_index, us);
+            start(_index);
+        }
+
+        void cancel()
+        {
+            stop(_index);
+        }
+
+        private:
+        size_t _index = 0;
+
+        static constexpr uint64_t gcd(uint64_t a, uint64_t b)
+        {
+            return b ? gcd(b, a % b) : a;
+        }
+    };
+}    // namespace core::mcu::timers
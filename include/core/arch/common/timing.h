@@ -37,11 +37,25 @@
 #endif
 #endif
 
+// Define CORE_MCU_TIMING_TICKLESS to use tickless mode: ms() is then computed from the
+// free-running counter instead of being incremented in periodic interrupt, so that no
+// timer from core::mcu::timers is allocated. Not available on AVR.
+
 namespace core::mcu::timing
 {
     void     init();
     uint32_t ms();
     void     waitMs(uint32_t ms);
+
+    /// Returns the amount of microseconds since init, wrapping around in about 71 minutes.
+    uint32_t us();
+
+    /// Returns the amount of ticks of free-running counter since init.
+    /// Tick frequency is MCU-specific, see TICKS_PER_SECOND.
+    uint64_t ticks();
+
+    /// Returns the total amount of microseconds spent asleep in core::mcu::idle() since init.
+    uint64_t idleUs();
 }    // namespace core::mcu::timing
 
 #else
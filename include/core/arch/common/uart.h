@@ -21,17 +21,33 @@
 
 #pragma once
 
-#ifndef CORE_MCU_STUB
-
 #include <inttypes.h>
-#include <functional>
 #include "core/util/ring_buffer.h"
+#include "core/util/handler.h"
+#include "core/arch/common/timing.h"
 #include "core/mcu.h"
 
 namespace core::mcu::uart
 {
-    using rxHandler_t = std::function<void(uint8_t data)>;
-    using txHandler_t = std::function<bool(uint8_t& data, size_t& remainingBytes)>;
+    using rxHandler_t = core::util::Handler<void(uint8_t data)>;
+    using txHandler_t = core::util::Handler<bool(uint8_t& data, size_t& remainingBytes)>;
+
+    /// Block-based counterpart of rxHandler_t/txHandler_t.
+    struct SpanHandler
+    {
+        using rxHandler_t = core::util::Handler<void(const uint8_t* data, size_t size)>;
+        using txHandler_t = core::util::Handler<const uint8_t*(size_t sentBytes, size_t& size)>;
+
+        /// Stores the block of received data.
+        rxHandler_t received;
+
+        /// Releases specified amount of bytes from previously retrieved block and
+        /// returns the next contiguous block of data which needs to be sent.
+        /// param [in]: sentBytes   Amount of bytes sent from previously retrieved block.
+        /// param [in]: size        Reference to variable in which the size of next block will be stored.
+        ///                         Set to zero if there is nothing to send.
+        txHandler_t next;
+    };
 
     class Config
     {
@@ -104,6 +120,12 @@ namespace core::mcu::uart
         stopBits_t stopBits;
         type_t     type;
         pins_t     pins;
+
+        /// Use DMA for data transfers instead of interrupt per byte.
+        /// Ignored on MCUs for which DMA isn't supported. On STM32, also ignored unless
+        /// CORE_MCU_UART_DMA is defined, since the UART driver then owns the interrupts of
+        /// the DMA streams mapped to UART.
+        bool dma = false;
     };
 
     namespace hw
@@ -112,7 +134,12 @@ namespace core::mcu::uart
         /// param [in]: config      Structure containing UART channel configuration.
         /// param [in]: rxHandler   Function which will be called from hardware UART interrupt when new data is received.
         /// param [in]: txHandler   Function which will be called from hardware UART interrupt when new data needs to be sent.
-        bool init(const Config& config, rxHandler_t&& rxHandler, txHandler_t&& txHandler);
+        /// param [in]: spanHandler Block-based handlers used instead of rxHandler and txHandler by the hardware
+        ///                         which supports it (DMA, hardware FIFO or cached single-byte transfers).
+        bool init(const Config&      config,
+                  rxHandler_t&&      rxHandler,
+                  txHandler_t&&      txHandler,
+                  const SpanHandler& spanHandler);
 
         /// Performs low-level deinitialization of the specified UART channel.
         /// param [in]: config      Structure containing UART channel configuration.
@@ -140,13 +167,11 @@ namespace core::mcu::uart
 
             if (hw::init(
                     config,
-                    [this](uint8_t data)
-                    {
-                        storeIncomingData(data);
-                    },
-                    [this](uint8_t& data, size_t& remainingBytes)
-                    {
-                        return getNextByteToSend(data, remainingBytes);
+                    rxHandler_t::bind<Channel, &Channel::storeIncomingData>(*this),
+                    txHandler_t::bind<Channel, &Channel::getNextByteToSend>(*this),
+                    SpanHandler{
+                        SpanHandler::rxHandler_t::bind<Channel, &Channel::storeIncomingData>(*this),
+                        SpanHandler::txHandler_t::bind<Channel, &Channel::getNextBlockToSend>(*this),
                     }))
             {
                 _initialized     = true;
@@ -156,6 +181,7 @@ namespace core::mcu::uart
                 _config.stopBits = config.stopBits;
                 _config.type     = config.type;
                 _config.pins     = config.pins;
+                _config.dma      = config.dma;
 
                 return true;
             }
@@ -199,15 +225,7 @@ namespace core::mcu::uart
         /// returns: True if data is available, false otherwise.
         bool read(uint8_t* buffer, size_t& size, const size_t maxSize)
         {
-            size = 0;
-
-            while (_rxBuffer.remove(buffer[size++]))
-            {
-                if (size >= maxSize)
-                {
-                    break;
-                }
-            }
+            size = _rxBuffer.remove(buffer, maxSize);
 
             return size > 0;
         }
@@ -222,20 +240,60 @@ namespace core::mcu::uart
             return _rxBuffer.remove(value);
         }
 
+        /// Used to write as much data as currently fits into UART TX buffer, without blocking.
+        /// Transmission is started once for the entire accepted batch.
+        /// param [in]: buffer      Pointer to array holding data to send.
+        /// param [in]: size        Amount of bytes in provided buffer.
+        /// returns: Amount of bytes accepted into TX buffer.
+        size_t tryWrite(const uint8_t* buffer, size_t size)
+        {
+            auto written = _txBuffer.insert(buffer, size);
+
+            if (written)
+            {
+                hw::startTx(_config);
+            }
+
+            return written;
+        }
+
         /// Used to write data to UART TX buffer.
+        /// Blocks until all the data is accepted into TX buffer.
         /// param [in]: buffer      Pointer to array holding data to send.
         /// param [in]: size        Amount of bytes in provided buffer.
         /// returns: True on success, false otherwise
-        bool write(uint8_t* buffer, size_t size)
+        bool write(const uint8_t* buffer, size_t size)
         {
-            for (size_t i = 0; i < size; i++)
+            while (size)
             {
-                while (!_txBuffer.insert(buffer[i]))
+                auto written = tryWrite(buffer, size);
+                buffer += written;
+                size -= written;
+            }
+
+            return true;
+        }
+
+        /// Used to write data to UART TX buffer.
+        /// Blocks until all the data is accepted into TX buffer or until the specified timeout expires.
+        /// param [in]: buffer      Pointer to array holding data to send.
+        /// param [in]: size        Amount of bytes in provided buffer.
+        /// param [in]: timeout     Maximum time in milliseconds to wait for free space in TX buffer.
+        /// returns: True if all the data has been accepted into TX buffer, false if timeout has expired.
+        bool write(const uint8_t* buffer, size_t size, uint32_t timeout)
+        {
+            const uint32_t START = core::mcu::timing::ms();
+
+            while (size)
+            {
+                auto written = tryWrite(buffer, size);
+                buffer += written;
+                size -= written;
+
+                if (size && ((core::mcu::timing::ms() - START) >= timeout))
                 {
-                    ;
+                    return false;
                 }
-
-                hw::startTx(_config);
             }
 
             return true;
@@ -249,6 +307,18 @@ namespace core::mcu::uart
             return write(&value, 1);
         }
 
+        /// Returns the amount of bytes which can currently be written to UART TX buffer without blocking.
+        size_t txFreeSpace()
+        {
+            return _txBuffer.freeSpace();
+        }
+
+        /// Returns the amount of received bytes which can currently be read.
+        size_t rxAvailable()
+        {
+            return _rxBuffer.size();
+        }
+
         /// Used to enable or disable UART loopback functionality.
         /// Used to pass incoming UART data to TX channel immediately.
         /// param [in]: state   New state of loopback functionality (true/enabled, false/disabled).
@@ -273,6 +343,21 @@ namespace core::mcu::uart
             }
         }
 
+        void storeIncomingData(const uint8_t* data, size_t size)
+        {
+            if (!_loopbackEnabled)
+            {
+                _rxBuffer.insert(data, size);
+            }
+            else
+            {
+                if (_txBuffer.insert(data, size))
+                {
+                    hw::startTx(_config);
+                }
+            }
+        }
+
         bool getNextByteToSend(uint8_t& data, size_t& remainingBytes)
         {
             if (_txBuffer.remove(data))
@@ -286,6 +371,14 @@ namespace core::mcu::uart
             return false;
         }
 
+        const uint8_t* getNextBlockToSend(size_t sentBytes, size_t& size)
+        {
+            // data handed out previously is sent directly from the buffer,
+            // so release it only once the transfer is done
+            _txBuffer.consume(sentBytes);
+            return _txBuffer.readSpan(size);
+        }
+
         Config _config;
 
         /// Flag holding the state of UART interface (whether it's initialized or not).
@@ -303,6 +396,3 @@ namespace core::mcu::uart
     };
 }    // namespace core::mcu::uart
 
-#else
-#include "core/arch/stub/uart.h"
-#endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Internal
+// Architecture-independent part of DMA based UART reception: no MCU registers
+// are touched here so that the buffer management can also be used on stub MCU.
+
+namespace core::mcu::uart
+{
+    /// Buffer into which DMA continuously writes incoming data in circular mode.
+    /// Tracks how much of the data has already been passed on and hands out the
+    /// newly received data in at most two contiguous blocks (before and after the wrap).
+    template<size_t size>
+    class DmaRxBuffer
+    {
+        static_assert(size > 1, "DMA RX buffer needs to hold at least two bytes.");
+
+        public:
+        DmaRxBuffer() = default;
+
+        static constexpr size_t BUFFER_SIZE = size;
+
+        uint8_t* data()
+        {
+            return _buffer;
+        }
+
+        /// Passes all the data received since the last call to provided handler.
+        /// param [in]: remaining   Amount of transfers the DMA has left until the end of the buffer
+        ///                         (eg. NDTR register on STM32).
+        /// param [in]: handler     Callable with (const uint8_t* data, size_t size) signature.
+        template<typename Handler>
+        void update(size_t remaining, Handler&& handler)
+        {
+            // once the end is reached, counter is reloaded to full size: position wraps to zero
+            const size_t POSITION = (remaining >= BUFFER_SIZE) ? 0 : BUFFER_SIZE - remaining;
+
+            if (POSITION == _readPosition)
+            {
+                return;
+            }
+
+            if (POSITION > _readPosition)
+            {
+                handler(&_buffer[_readPosition], POSITION - _readPosition);
+            }
+            else
+            {
+                handler(&_buffer[_readPosition], BUFFER_SIZE - _readPosition);
+
+                if (POSITION)
+                {
+                    handler(&_buffer[0], POSITION);
+                }
+            }
+
+            _readPosition = POSITION;
+        }
+
+        void reset()
+        {
+            _readPosition = 0;
+        }
+
+        private:
+        uint8_t _buffer[BUFFER_SIZE] = {};
+        size_t  _readPosition        = 0;
+    };
+
+    /// Pair of buffers used by DMA which can't run in circular mode (eg. nRF52 EasyDMA):
+    /// while one buffer is being filled, the other one is queued as the next transfer target.
+    template<size_t size>
+    class DmaRxDoubleBuffer
+    {
+        static_assert(size > 0, "DMA RX buffer needs to hold at least one byte.");
+
+        public:
+        DmaRxDoubleBuffer() = default;
+
+        static constexpr size_t BUFFER_SIZE = size;
+
+        /// Returns the buffer into which DMA is currently storing data.
+        uint8_t* active()
+        {
+            return _buffer[_active];
+        }
+
+        /// Returns the buffer which should be used for the following transfer.
+        uint8_t* next()
+        {
+            return _buffer[!_active];
+        }
+
+        /// Passes the data stored into active buffer to provided handler and swaps the buffers.
+        /// param [in]: amount      Amount of bytes DMA has stored into active buffer.
+        /// param [in]: handler     Callable with (const uint8_t* data, size_t size) signature.
+        template<typename Handler>
+        void complete(size_t amount, Handler&& handler)
+        {
+            if (amount)
+            {
+                handler(active(), amount > BUFFER_SIZE ? BUFFER_SIZE : amount);
+            }
+
+            _active = !_active;
+        }
+
+        void reset()
+        {
+            _active = false;
+        }
+
+        private:
+        uint8_t _buffer[2][BUFFER_SIZE] = {};
+        bool    _active                 = false;
+    };
+}    // namespace core::mcu::uart
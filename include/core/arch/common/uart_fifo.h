@@ -0,0 +1,155 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Internal
+// Architecture-independent transfer of data between UART hardware (with or without FIFO)
+// and block-based channel handlers. Hardware FIFO access is abstracted through Fifo type so
+// that the same logic can run against simulated UART on stub MCU.
+//
+// Fifo needs to provide the following:
+//  bool    readable();
+//  uint8_t read();
+//  bool    writable();
+//  void    write(uint8_t data);
+
+namespace core::mcu::uart
+{
+    /// Moves all the data from RX FIFO to provided handler, in blocks of up to fifoSize bytes.
+    /// param [in]: fifo        Hardware FIFO accessor.
+    /// param [in]: handler     Callable with (const uint8_t* data, size_t size) signature.
+    /// returns: Total amount of read bytes.
+    template<size_t fifoSize, typename Fifo, typename Handler>
+    size_t drainRxFifo(Fifo& fifo, Handler&& handler)
+    {
+        uint8_t buffer[fifoSize];
+        size_t  total = 0;
+
+        while (fifo.readable())
+        {
+            size_t count = 0;
+
+            while ((count < fifoSize) && fifo.readable())
+            {
+                buffer[count++] = fifo.read();
+            }
+
+            handler(buffer, count);
+            total += count;
+        }
+
+        return total;
+    }
+
+    /// Fills TX FIFO with as much data as it can accept.
+    /// param [in]: fifo        Hardware FIFO accessor.
+    /// param [in]: handler     Callable with (size_t sentBytes, size_t& size) signature, returning pointer
+    ///                         to the next contiguous block of data and releasing sentBytes bytes from
+    ///                         previously returned block.
+    /// returns: True if there is more data waiting to be sent, false otherwise.
+    template<typename Fifo, typename Handler>
+    bool fillTxFifo(Fifo& fifo, Handler&& handler)
+    {
+        size_t size = 0;
+        auto   data = handler(0, size);
+
+        while (size && fifo.writable())
+        {
+            size_t written = 0;
+
+            while ((written < size) && fifo.writable())
+            {
+                fifo.write(data[written++]);
+            }
+
+            data = handler(written, size);
+        }
+
+        return size;
+    }
+
+    /// Hands out outgoing data byte by byte for hardware without TX FIFO.
+    /// Block retrieved from handler is cached until fully sent, so that the handler is
+    /// called once per contiguous block instead of once per byte.
+    class TxSpanCursor
+    {
+        public:
+        /// Retrieves the next byte to send.
+        /// param [in]: handler         Callable with (size_t sentBytes, size_t& size) signature, same as in fillTxFifo.
+        /// param [in]: data            Reference to variable in which the next byte will be stored.
+        /// param [in]: remainingBytes  Reference to variable in which the amount of bytes waiting to be sent
+        ///                             after this one will be stored.
+        /// returns: True if there is data to send, false otherwise.
+        template<typename Handler>
+        bool next(Handler&& handler, uint8_t& data, size_t& remainingBytes)
+        {
+            if (!_size)
+            {
+                fetch(handler);
+
+                if (!_size)
+                {
+                    remainingBytes = 0;
+                    return false;
+                }
+            }
+
+            data = *_data++;
+            _size--;
+            _sent++;
+
+            if (!_size)
+            {
+                // release the block as soon as possible and check whether there is more data
+                fetch(handler);
+            }
+
+            remainingBytes = _size;
+            return true;
+        }
+
+        /// Drops cached block without releasing it.
+        /// Used once the channel buffers are reset.
+        void reset()
+        {
+            _data = nullptr;
+            _size = 0;
+            _sent = 0;
+        }
+
+        private:
+        const uint8_t* _data = nullptr;
+        size_t         _size = 0;
+        size_t         _sent = 0;
+
+        template<typename Handler>
+        void fetch(Handler&& handler)
+        {
+            _data = handler(_sent, _size);
+            _sent = 0;
+        }
+    };
+}    // namespace core::mcu::uart
@@ -26,18 +26,16 @@
 
 namespace core::mcu::bootloader
 {
-    inline bool erasePage(size_t index)
-    {
-        return false;
-    }
-
-    inline bool fillPage(size_t index, uint32_t addressInPage, uint32_t data)
-    {
-        return false;
-    }
-
-    inline bool commitPage(size_t index)
-    {
-        return false;
-    }
+    // same as on real MCUs: pages are written through bootloader cache to simulated flash
+    bool erasePage(size_t index);
+    bool fillPage(size_t index, uint32_t addressInPage, uint32_t data);
+    bool commitPage(size_t index);
+
+    /// Enables or disables differential update mode.
+    /// In this mode, pages whose contents match the incoming data are neither erased nor programmed.
+    /// Resets the amount of skipped pages.
+    void setDifferentialMode(bool state);
+
+    /// Returns the amount of pages skipped in differential update mode.
+    size_t skippedPages();
 }    // namespace core::mcu::bootloader
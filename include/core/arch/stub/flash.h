@@ -23,18 +23,34 @@
 
 #include <inttypes.h>
 #include <cstddef>
+#include "core/arch/common/flash_async.h"
+
+#define CORE_MCU_FLASH_ASYNC
 
 namespace core::mcu::flash
 {
-    inline bool init()
+    // Simulated flash mimics external QSPI flash on RP2040: data is programmed in 256-byte
+    // pages while the smallest erasable unit is 4096-byte sector. Writes are cached in the
+    // same way as on RP2040 so that the amount of flash operations can be verified on host.
+    constexpr uint32_t STUB_PROGRAM_PAGE_SIZE = 256;
+    constexpr uint32_t STUB_SECTOR_SIZE       = 4096;
+    constexpr uint32_t STUB_SECTORS           = 16;
+
+    // typical QSPI NOR flash timings, used to estimate the time spent in flash operations
+    constexpr uint32_t STUB_ERASE_TIME_US   = 45000;
+    constexpr uint32_t STUB_PROGRAM_TIME_US = 700;
+
+    /// Statistics of low-level operations performed on simulated flash.
+    struct stats_t
     {
-        return false;
-    }
+        size_t   erases          = 0;
+        size_t   programs        = 0;
+        size_t   programmedBytes = 0;
+        uint32_t busyTime        = 0;    ///< Estimated time spent in flash operations, in microseconds.
+    };
 
-    inline bool isInRange(uint32_t address)
-    {
-        return false;
-    }
+    /// Resets simulated flash to erased state and clears the statistics.
+    bool init();
 
     inline uint32_t startAddress()
     {
@@ -43,41 +59,57 @@ namespace core::mcu::flash
 
     inline uint32_t size()
     {
-        return 0;
+        return STUB_SECTOR_SIZE * STUB_SECTORS;
     }
 
     inline uint32_t pageSize(size_t index)
     {
-        return 0;
+        return STUB_SECTOR_SIZE;
     }
 
     inline uint32_t pageAddress(size_t index)
     {
-        return 0;
+        return startAddress() + (index * STUB_SECTOR_SIZE);
     }
 
-    inline bool erasePage(size_t index)
-    {
-        return false;
-    }
-
-    inline bool write32(uint32_t address, uint32_t data)
-    {
-        return false;
-    }
-
-    inline bool read8(uint32_t address, uint8_t& data)
-    {
-        return false;
-    }
-
-    inline bool read16(uint32_t address, uint16_t& data)
+    inline bool isInRange(uint32_t address)
     {
-        return false;
+        return (address >= startAddress()) && (address < (startAddress() + size()));
     }
 
-    inline bool read32(uint32_t address, uint32_t& data)
+    bool    erasePage(size_t index);
+    bool    write32(uint32_t address, uint32_t data);
+    bool    write(uint32_t address, const uint8_t* data, size_t size);
+    bool    flush();
+    bool    read8(uint32_t address, uint8_t& data);
+    bool    read16(uint32_t address, uint16_t& data);
+    bool    read32(uint32_t address, uint32_t& data);
+    bool    read(uint32_t address, uint8_t* data, size_t size);
+    stats_t stats();
+    void    resetStats();
+
+    // Asynchronous operations complete once the simulated time (see core::mcu::timing::setMs)
+    // has advanced by the estimated duration of the operation. Data is written at completion.
+    namespace async
     {
-        return false;
-    }
-}    // namespace core::mcu::flash
\ No newline at end of file
+        /// Queues erase of the page.
+        /// returns: False if the queue is full, true otherwise.
+        bool erasePage(size_t index, callback_t callback = nullptr, void* context = nullptr);
+
+        /// Queues write of block of data.
+        /// Address, size and data pointer need to be 4-byte aligned. Data needs to remain
+        /// valid until the operation is completed.
+        /// returns: False if the queue is full or if the request is invalid, true otherwise.
+        bool write(uint32_t address, const uint8_t* data, size_t size, callback_t callback = nullptr, void* context = nullptr);
+
+        /// Calls the callbacks of finished operations: needs to be called periodically
+        /// from the main loop.
+        void update();
+
+        /// Returns the amount of queued operations whose callbacks haven't been called yet.
+        size_t pending();
+
+        /// Checks whether any flash operation is in progress.
+        bool isBusy();
+    }    // namespace async
+}    // namespace core::mcu::flash
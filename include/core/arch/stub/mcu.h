@@ -24,6 +24,7 @@
 #define CORE_MCU_NOP()
 
 #include <inttypes.h>
+#include <array>
 #include "adc.h"
 #include "atomic.h"
 #include "bootloader.h"
@@ -39,6 +40,7 @@
 #include "uart.h"
 #include "usb.h"
 #include "util.h"
+#include "core/arch/common/uart.h"
 #include "core/arch/common/usb/usb.h"
 
 namespace core::mcu
@@ -67,7 +69,10 @@ namespace core::mcu
     {
     }
 
-    inline void idle()
-    {
-    }
+    /// Advances simulated time until the next timing interrupt, but by no more than maxUs,
+    /// as if the core was put to sleep.
+    void idle(uint32_t maxUs = 0);
+
+    /// Makes the next call to idle() return without advancing the time.
+    void wake();
 }    // namespace core::mcu
\ No newline at end of file
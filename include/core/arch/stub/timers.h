@@ -23,17 +23,13 @@
 
 #include <inttypes.h>
 #include <cstddef>
-#ifndef CORE_USE_C_TIMER_CALLBACK
-#include <functional>
-#endif
+#include "core/util/handler.h"
 
 namespace core::mcu::timers
 {
-#ifdef CORE_USE_C_TIMER_CALLBACK
-    using handler_t = void (*)();
-#else
-    using handler_t = std::function<void()>;
-#endif
+    /// Called from timer interrupt. Accepts plain functions, lambdas without captures
+    /// or functions bound at compile time with handler_t::bind.
+    using handler_t = core::util::Handler<void()>;
 
     inline bool init()
     {
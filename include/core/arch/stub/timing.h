@@ -29,8 +29,24 @@ namespace core::mcu::timing
     {
     }
 
+    // Simulated time only advances when set explicitly so that the code using it can be
+    // tested deterministically. One tick equals one microsecond.
+    constexpr uint32_t TICKS_PER_SECOND = 1000000;
+
+    // Width of simulated free-running counter. Timing interrupts are counted as the simulated
+    // time advances: in default mode, one each millisecond, and in tickless mode (see
+    // CORE_MCU_TIMING_TICKLESS) one on each wraparound of the counter.
+    constexpr uint32_t STUB_COUNTER_BITS = 24;
+
     void     setMs(uint32_t ms);
+    void     setTicks(uint64_t ticks);
+    void     advanceUs(uint32_t us);
     uint32_t ms();
+    uint32_t us();
+    uint64_t ticks();
+    uint32_t isrCount();
+    void     resetIsrCount();
+    uint64_t idleUs();
 
     inline void waitMs(uint32_t ms)
     {
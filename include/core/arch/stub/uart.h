@@ -21,8 +21,8 @@
 
 #pragma once
 
-#include <functional>
-#include "core/util/ring_buffer.h"
+#include <inttypes.h>
+#include <stddef.h>
 
 #define UCSRA_0 (*(volatile uint32_t*)(1))
 #define UCSRA_1 (*(volatile uint32_t*)(1))
@@ -78,155 +78,41 @@
 
 namespace core::mcu::uart
 {
-    using rxHandler_t = std::function<void(uint8_t data)>;
-    using txHandler_t = std::function<bool(uint8_t& data, size_t& remainingBytes)>;
-
-    class Config
+    // Simulated UART: data is moved between the line and the channel only when requested
+    // through the functions below, the same way hardware would do it, so that the buffer
+    // management can be tested on host. With Config::dma set, RX runs as circular DMA
+    // transfer which is flushed on half and full transfer and on idle line, while TX sends
+    // contiguous blocks straight out of the channel TX buffer. Otherwise, interrupt is taken
+    // for each byte, unless hardware FIFOs are enabled (see setFifoState).
+    constexpr size_t STUB_DMA_RX_BUFFER_SIZE = 64;
+
+    // Simulated hardware FIFOs behave as on RP2040: RX interrupt is taken once RX FIFO is
+    // half full or on RX timeout (once the data stops arriving), and TX interrupt once TX
+    // FIFO drops to 1/8 of its size.
+    constexpr size_t STUB_FIFO_SIZE         = 32;
+    constexpr size_t STUB_FIFO_RX_THRESHOLD = STUB_FIFO_SIZE / 2;
+    constexpr size_t STUB_FIFO_TX_THRESHOLD = STUB_FIFO_SIZE / 8;
+
+    /// Amount of simulated interrupts taken by the channel.
+    struct stats_t
     {
-        public:
-        enum parity_t : uint8_t
-        {
-            NO,
-            EVEN,
-            ODD
-        };
-
-        enum stopBits_t : uint8_t
-        {
-            ONE,
-            TWO
-        };
-
-        enum type_t : uint8_t
-        {
-            RX_TX,
-            RX,
-            TX
-        };
-
-        struct pins_t
-        {
-            core::mcu::io::pin_t rx;
-            core::mcu::io::pin_t tx;
-        };
-
-        Config(uint8_t    channel,
-               uint32_t   baudRate,
-               parity_t   parity,
-               stopBits_t stopBits,
-               type_t     type,
-               pins_t     pins)
-            : channel(channel)
-            , baudRate(baudRate)
-            , parity(parity)
-            , stopBits(stopBits)
-            , type(type)
-            , pins(pins)
-        {}
-
-        Config(uint8_t    channel,
-               uint32_t   baudRate,
-               parity_t   parity,
-               stopBits_t stopBits,
-               type_t     type)
-            : channel(channel)
-            , baudRate(baudRate)
-            , parity(parity)
-            , stopBits(stopBits)
-            , type(type)
-            , pins({})
-        {}
-
-        Config()
-            : channel(0)
-            , baudRate(9600)
-            , parity(parity_t::NO)
-            , stopBits(stopBits_t::ONE)
-            , type(type_t::RX_TX)
-            , pins({})
-        {}
-
-        uint8_t    channel;
-        uint32_t   baudRate;
-        parity_t   parity;
-        stopBits_t stopBits;
-        type_t     type;
-        pins_t     pins;
+        size_t rxInterrupts = 0;
+        size_t txInterrupts = 0;
     };
 
-    namespace hw
-    {
-        /// Performs low-level initialization of the specified UART channel.
-        /// param [in]: config      Structure containing UART channel configuration.
-        /// param [in]: rxHandler   Function which will be called from hardware UART interrupt when new data is received.
-        /// param [in]: txHandler   Function which will be called from hardware UART interrupt when new data needs to be sent.
-        inline bool init(const Config& config, rxHandler_t&& rxHandler, txHandler_t&& txHandler)
-        {
-            return false;
-        }
+    /// Simulates reception of data on the line. Data which arrives back to back (without
+    /// idle line in between) needs to be provided at once.
+    /// returns: False if the channel isn't initialized for reception, true otherwise.
+    bool receive(uint8_t channel, const uint8_t* data, size_t size);
 
-        /// Performs low-level deinitialization of the specified UART channel.
-        /// param [in]: config      Structure containing UART channel configuration.
-        inline bool deInit(const Config& config)
-        {
-            return false;
-        }
+    /// Lets the line transmit up to maxSize bytes of the data queued for sending.
+    /// returns: Amount of transmitted bytes, stored into provided buffer.
+    size_t transmit(uint8_t channel, uint8_t* data, size_t maxSize);
 
-        /// Used to start the process of transmitting the data from UART TX buffer to UART interface.ž
-        /// param [in]: config      Structure containing UART channel configuration.
-        void startTx(const Config& config);
-    };    // namespace hw
-
-    template<size_t txSize, size_t rxSize>
-    class Channel
-    {
-        public:
-        Channel() = default;
+    /// Enables or disables hardware FIFOs of the channel. Ignored when the channel uses DMA.
+    /// Needs to be set while the channel isn't initialized.
+    void setFifoState(uint8_t channel, bool state);
 
-        bool init(const Config& config)
-        {
-            return false;
-        }
-
-        bool deInit()
-        {
-            return false;
-        }
-
-        bool isInitialized()
-        {
-            return false;
-        }
-
-        bool read(uint8_t* buffer, size_t& size, const size_t maxSize)
-        {
-            return false;
-        }
-
-        bool read(uint8_t& value)
-        {
-            return false;
-        }
-
-        bool write(uint8_t* buffer, size_t size)
-        {
-            return false;
-        }
-
-        bool write(uint8_t value)
-        {
-            return false;
-        }
-
-        void setLoopbackState(bool state)
-        {
-        }
-
-        private:
-        /// Buffer in which outgoing UART data is stored.
-        core::util::RingBuffer<uint8_t, txSize> _txBuffer;
-
-        /// Buffer in which incoming UART data is stored.
-        core::util::RingBuffer<uint8_t, rxSize> _rxBuffer;
-    };
-}    // namespace core::mcu::uart
\ No newline at end of file
+    stats_t stats(uint8_t channel);
+    void    resetStats(uint8_t channel);
+}    // namespace core::mcu::uart
@@ -0,0 +1,673 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#if __cplusplus < 202002L
+#error "Coroutines require C++20"
+#endif
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <coroutine>
+#include "core/mcu.h"
+#include "core/util/handler.h"
+#include "core/util/ring_buffer.h"
+#include "core/util/scheduler.h"
+#include "core/util/messaging/messaging.h"
+
+// Stackless cooperative tasks. Coroutine function returns coro::Coroutine and is started
+// through coro::Runtime::spawn(). Coroutines are resumed only from Runtime::run(), called
+// from the main loop: awaited events (timeouts of core::util::Scheduler tasks, flash
+// completion callbacks, notifications) only mark them as ready.
+// Frames are allocated from static pool of CORE_UTIL_CORO_FRAMES blocks, each
+// CORE_UTIL_CORO_FRAME_SIZE bytes large. Both can be overridden by defining
+// CORE_UTIL_CORO_FRAMES_USER and CORE_UTIL_CORO_FRAME_SIZE_USER. Coroutine whose frame
+// doesn't fit into the block, or for which no block is free, isn't created.
+
+#ifdef CORE_UTIL_CORO_FRAMES_USER
+#define CORE_UTIL_CORO_FRAMES CORE_UTIL_CORO_FRAMES_USER
+#else
+#define CORE_UTIL_CORO_FRAMES 8
+#endif
+
+#ifdef CORE_UTIL_CORO_FRAME_SIZE_USER
+#define CORE_UTIL_CORO_FRAME_SIZE CORE_UTIL_CORO_FRAME_SIZE_USER
+#elif defined(CORE_UTIL_SCHEDULER_STATS)
+// each frame holds scheduler task which is larger when statistics are collected
+#define CORE_UTIL_CORO_FRAME_SIZE 256
+#else
+#define CORE_UTIL_CORO_FRAME_SIZE 192
+#endif
+
+namespace core::util::coro
+{
+    class Runtime;
+
+    namespace detail
+    {
+        class FramePool
+        {
+            public:
+            static constexpr size_t FRAMES     = CORE_UTIL_CORO_FRAMES;
+            static constexpr size_t FRAME_SIZE = (CORE_UTIL_CORO_FRAME_SIZE + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+
+            FramePool()
+            {
+                for (size_t i = 0; i < FRAMES; i++)
+                {
+                    release(&_frames[i]);
+                }
+            }
+
+            void* allocate(size_t size)
+            {
+                if ((size > FRAME_SIZE) || (_free == nullptr))
+                {
+                    return nullptr;
+                }
+
+                Block* block = _free;
+                _free        = block->next;
+
+                return block;
+            }
+
+            void release(void* frame)
+            {
+                auto block  = static_cast<Block*>(frame);
+                block->next = _free;
+                _free       = block;
+            }
+
+            private:
+            union Block
+            {
+                Block* next;
+                alignas(max_align_t) uint8_t data[FRAME_SIZE];
+            };
+
+            Block  _frames[FRAMES];
+            Block* _free = nullptr;
+        };
+
+        inline FramePool framePool;
+    }    // namespace detail
+
+    class Coroutine
+    {
+        public:
+        class promise_type
+        {
+            public:
+            promise_type()
+                : _timer(0, Task::taskType_t::ONE_SHOT, Task::taskFunc_t::bind<promise_type, &promise_type::wake>(*this))
+            {}
+
+            static void* operator new(size_t size) noexcept
+            {
+                return detail::framePool.allocate(size);
+            }
+
+            static void operator delete(void* frame)
+            {
+                detail::framePool.release(frame);
+            }
+
+            static Coroutine get_return_object_on_allocation_failure()
+            {
+                return Coroutine(nullptr);
+            }
+
+            Coroutine get_return_object()
+            {
+                return Coroutine(handle_t::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void()
+            {}
+
+            void unhandled_exception()
+            {}
+
+            /// Marks the coroutine as ready to be resumed.
+            void wake();
+
+            private:
+            friend class Runtime;
+            friend class SleepAwaiter;
+            friend class ConditionAwaiter;
+
+            Runtime*        _runtime   = nullptr;
+            promise_type*   _next      = nullptr;    ///< Link in the list of ready or waiting coroutines.
+            promise_type*   _previous  = nullptr;    ///< Links in the list of all coroutines of the runtime.
+            promise_type*   _following = nullptr;
+            bool            _ready     = false;
+            Task            _timer;
+            Handler<bool()> _condition;
+        };
+
+        using handle_t = std::coroutine_handle<promise_type>;
+
+        Coroutine(Coroutine&& other)
+            : _handle(other._handle)
+        {
+            other._handle = nullptr;
+        }
+
+        Coroutine(const Coroutine&)            = delete;
+        Coroutine& operator=(const Coroutine&) = delete;
+        Coroutine& operator=(Coroutine&&)      = delete;
+
+        /// Frame of the coroutine which hasn't been spawned is released here.
+        ~Coroutine()
+        {
+            if (_handle)
+            {
+                _handle.destroy();
+            }
+        }
+
+        /// Checks whether the frame could be allocated.
+        bool isValid() const
+        {
+            return static_cast<bool>(_handle);
+        }
+
+        private:
+        friend class Runtime;
+
+        explicit Coroutine(handle_t handle)
+            : _handle(handle)
+        {}
+
+        handle_t _handle;
+    };
+
+    using promise_t = Coroutine::promise_type;
+    using handle_t  = Coroutine::handle_t;
+
+    class Runtime
+    {
+        public:
+        /// Sleeping coroutines use a task of the provided scheduler each: scheduler capacity
+        /// needs to account for all the coroutines running at once.
+        explicit Runtime(Scheduler& scheduler)
+            : _scheduler(scheduler)
+        {}
+
+        Runtime(const Runtime&)            = delete;
+        Runtime& operator=(const Runtime&) = delete;
+
+        /// Coroutines which haven't finished yet are released.
+        ~Runtime()
+        {
+            while (_all != nullptr)
+            {
+                finish(*_all);
+            }
+        }
+
+        /// Takes over the coroutine and schedules it to run from the next call to run().
+        /// returns: False if the coroutine frame couldn't be allocated or if the scheduler
+        /// is full, true otherwise.
+        bool spawn(Coroutine&& coroutine)
+        {
+            if (!coroutine._handle)
+            {
+                return false;
+            }
+
+            auto& promise = coroutine._handle.promise();
+
+            if (!_scheduler.registerTask(promise._timer))
+            {
+                return false;
+            }
+
+            promise._runtime   = this;
+            promise._following = _all;
+            coroutine._handle  = nullptr;
+
+            if (_all != nullptr)
+            {
+                _all->_previous = &promise;
+            }
+
+            _all = &promise;
+            _active++;
+            makeReady(promise);
+
+            return true;
+        }
+
+        /// Resumes the coroutines which are ready. Coroutines which become ready meanwhile
+        /// are resumed in the next call. Coroutines which have finished are released.
+        void run()
+        {
+            checkConditions();
+
+            promise_t* list = _ready;
+            _ready          = nullptr;
+            _readyTail      = nullptr;
+
+            while (list != nullptr)
+            {
+                promise_t& promise = *list;
+                list               = list->_next;
+                promise._next      = nullptr;
+                promise._ready     = false;
+
+                auto handle = handle_t::from_promise(promise);
+                handle.resume();
+
+                if (handle.done())
+                {
+                    finish(promise);
+                }
+            }
+        }
+
+        /// Checks whether any coroutine is ready to be resumed. If not, and no coroutine waits
+        /// for a condition, main loop can sleep until the next scheduler deadline.
+        bool isPending() const
+        {
+            return _ready != nullptr;
+        }
+
+        /// Checks whether any coroutine waits for a condition which is checked in run().
+        bool isPolling() const
+        {
+            return _waiting != nullptr;
+        }
+
+        /// Returns the amount of coroutines which haven't finished yet.
+        size_t active() const
+        {
+            return _active;
+        }
+
+        private:
+        friend class Coroutine::promise_type;
+        friend class ConditionAwaiter;
+
+        Scheduler& _scheduler;
+        promise_t* _all       = nullptr;
+        promise_t* _ready     = nullptr;
+        promise_t* _readyTail = nullptr;
+        promise_t* _waiting   = nullptr;
+        size_t     _active    = 0;
+
+        void makeReady(promise_t& promise)
+        {
+            if (promise._ready)
+            {
+                return;
+            }
+
+            promise._ready = true;
+            promise._next  = nullptr;
+
+            if (_readyTail != nullptr)
+            {
+                _readyTail->_next = &promise;
+            }
+            else
+            {
+                _ready = &promise;
+            }
+
+            _readyTail = &promise;
+        }
+
+        void wait(promise_t& promise)
+        {
+            promise._next = _waiting;
+            _waiting      = &promise;
+        }
+
+        void checkConditions()
+        {
+            promise_t** link = &_waiting;
+
+            while (*link != nullptr)
+            {
+                promise_t& promise = **link;
+
+                if (promise._condition())
+                {
+                    *link = promise._next;
+                    makeReady(promise);
+                }
+                else
+                {
+                    link = &promise._next;
+                }
+            }
+        }
+
+        void finish(promise_t& promise)
+        {
+            if (promise._previous != nullptr)
+            {
+                promise._previous->_following = promise._following;
+            }
+            else
+            {
+                _all = promise._following;
+            }
+
+            if (promise._following != nullptr)
+            {
+                promise._following->_previous = promise._previous;
+            }
+
+            _scheduler.unregisterTask(promise._timer);
+            handle_t::from_promise(promise).destroy();
+            _active--;
+        }
+    };
+
+    inline void Coroutine::promise_type::wake()
+    {
+        _runtime->makeReady(*this);
+    }
+
+    /// Resumes the coroutine once the scheduler task expires.
+    class SleepAwaiter
+    {
+        public:
+        explicit SleepAwaiter(uint32_t ms)
+            : _ms(ms)
+        {}
+
+        bool await_ready() const
+        {
+            return false;
+        }
+
+        void await_suspend(handle_t handle)
+        {
+            auto& promise = handle.promise();
+
+            if (_ms)
+            {
+                promise._timer.start(_ms);
+            }
+            else
+            {
+                // yield: resumed in the next run()
+                promise.wake();
+            }
+        }
+
+        void await_resume()
+        {}
+
+        private:
+        const uint32_t _ms;
+    };
+
+    /// Resumes the coroutine once the condition, checked in each Runtime::run(), is met.
+    class ConditionAwaiter
+    {
+        public:
+        explicit ConditionAwaiter(Handler<bool()> condition)
+            : _condition(condition)
+        {}
+
+        bool await_ready()
+        {
+            return _condition();
+        }
+
+        void await_suspend(handle_t handle)
+        {
+            auto& promise      = handle.promise();
+            promise._condition = _condition;
+            promise._runtime->wait(promise);
+        }
+
+        void await_resume()
+        {}
+
+        private:
+        Handler<bool()> _condition;
+    };
+
+    /// Suspends the coroutine for the specified amount of milliseconds, measured in the
+    /// time base of core::util::Scheduler. 0 only yields to other ready coroutines.
+    inline SleepAwaiter sleepMs(uint32_t ms)
+    {
+        return SleepAwaiter(ms);
+    }
+
+    /// Suspends the coroutine for at least the specified amount of microseconds. Scheduler
+    /// counts in milliseconds: the time is rounded up to the next millisecond.
+    inline SleepAwaiter sleepUs(uint32_t us)
+    {
+        return SleepAwaiter((us + 999) / 1000);
+    }
+
+    /// Resumes other ready coroutines before continuing.
+    inline SleepAwaiter yield()
+    {
+        return SleepAwaiter(0);
+    }
+
+    /// Suspends the coroutine until the condition is met.
+    inline ConditionAwaiter until(Handler<bool()> condition)
+    {
+        return ConditionAwaiter(condition);
+    }
+
+    /// Suspends the coroutine until UART channel has received at least the specified
+    /// amount of bytes. UART doesn't signal reception to the main loop: the amount is
+    /// checked in each Runtime::run() without resuming the coroutine.
+    template<typename Channel>
+    class UartAwaiter
+    {
+        public:
+        UartAwaiter(Channel& channel, size_t size)
+            : _channel(channel)
+            , _size(size)
+        {}
+
+        bool await_ready()
+        {
+            return received();
+        }
+
+        void await_suspend(handle_t handle)
+        {
+            ConditionAwaiter(Handler<bool()>::bind<UartAwaiter, &UartAwaiter::received>(*this)).await_suspend(handle);
+        }
+
+        void await_resume()
+        {}
+
+        private:
+        Channel&     _channel;
+        const size_t _size;
+
+        bool received()
+        {
+            return _channel.rxAvailable() >= _size;
+        }
+    };
+
+    template<typename Channel>
+    UartAwaiter<Channel> received(Channel& channel, size_t size)
+    {
+        return UartAwaiter<Channel>(channel, size);
+    }
+
+#ifdef CORE_MCU_FLASH_ASYNC
+    /// Queues asynchronous flash operation and resumes the coroutine once it completes.
+    /// Result of co_await is true if the operation has succeeded.
+    class FlashAwaiter
+    {
+        public:
+        FlashAwaiter(core::mcu::flash::async::operation_t operation, uint32_t address, const uint8_t* data, size_t size)
+            : _operation(operation)
+            , _address(address)
+            , _data(data)
+            , _size(size)
+        {}
+
+        bool await_ready() const
+        {
+            return false;
+        }
+
+        bool await_suspend(handle_t handle)
+        {
+            _promise = &handle.promise();
+
+            const bool QUEUED = (_operation == core::mcu::flash::async::operation_t::ERASE)
+                                    ? core::mcu::flash::async::erasePage(_address, completed, this)
+                                    : core::mcu::flash::async::write(_address, _data, _size, completed, this);
+
+            // continue right away with failure if the operation couldn't be queued
+            return QUEUED;
+        }
+
+        bool await_resume() const
+        {
+            return _success;
+        }
+
+        private:
+        const core::mcu::flash::async::operation_t _operation;
+        const uint32_t                             _address;
+        const uint8_t*                             _data;
+        const size_t                               _size;
+        promise_t*                                 _promise = nullptr;
+        bool                                       _success = false;
+
+        static void completed(void* context, bool success)
+        {
+            auto awaiter      = static_cast<FlashAwaiter*>(context);
+            awaiter->_success = success;
+            awaiter->_promise->wake();
+        }
+    };
+
+    inline FlashAwaiter erasePage(size_t index)
+    {
+        return FlashAwaiter(core::mcu::flash::async::operation_t::ERASE, index, nullptr, 0);
+    }
+
+    /// Data needs to remain valid until the operation is completed.
+    inline FlashAwaiter write(uint32_t address, const uint8_t* data, size_t size)
+    {
+        return FlashAwaiter(core::mcu::flash::async::operation_t::WRITE, address, data, size);
+    }
+#endif
+
+    /// Subscribes to the notification type and keeps the notifications received meanwhile
+    /// so that coroutine can await them one by one.
+    template<class NotificationType, size_t size = 4>
+    class Inbox
+    {
+        public:
+        Inbox()
+        {
+            _subscriber = MessagingServer.template subscribe<NotificationType>(
+                [this](const NotificationType& notification)
+                {
+                    return receive(notification);
+                });
+        }
+
+        Inbox(const Inbox&)            = delete;
+        Inbox& operator=(const Inbox&) = delete;
+
+        class Awaiter
+        {
+            public:
+            explicit Awaiter(Inbox& inbox)
+                : _inbox(inbox)
+            {}
+
+            bool await_ready() const
+            {
+                return !_inbox._notifications.isEmpty();
+            }
+
+            void await_suspend(handle_t handle)
+            {
+                _inbox._waiting = &handle.promise();
+            }
+
+            NotificationType await_resume()
+            {
+                NotificationType notification;
+                _inbox._notifications.remove(notification);
+
+                return notification;
+            }
+
+            private:
+            Inbox& _inbox;
+        };
+
+        /// Suspends the coroutine until a notification is available and returns it.
+        Awaiter next()
+        {
+            return Awaiter(*this);
+        }
+
+        private:
+        std::shared_ptr<core::util::messaging::Subscriber<NotificationType>> _subscriber;
+        RingBuffer<NotificationType, size>                                    _notifications;
+        promise_t*                                                            _waiting = nullptr;
+
+        core::util::messaging::notificationResult_t receive(const NotificationType& notification)
+        {
+            if (!_notifications.insert(notification))
+            {
+                // keep it in the subscriber queue, if used, until there is space
+                return core::util::messaging::notificationResult_t::DEFER;
+            }
+
+            if (_waiting != nullptr)
+            {
+                promise_t* promise = _waiting;
+                _waiting           = nullptr;
+                promise->wake();
+            }
+
+            return core::util::messaging::notificationResult_t::DONE;
+        }
+    };
+}    // namespace core::util::coro
@@ -0,0 +1,249 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <array>
+#include "core/util/util.h"
+
+#ifndef CORE_MCU_STUB
+#ifdef CORE_MCU_VENDOR_ST
+#include "core/arch/arm/st/common/crc.h"
+#endif
+#endif
+
+// Table-driven CRC-16/XMODEM and CRC-32 (as used by zlib, PNG, Ethernet).
+// Tables are generated at compile time. Processing N bytes per step (slice-by-N)
+// requires N tables: by default, single table is used on AVR (stored in program memory)
+// and four tables elsewhere. This can be overridden by defining CORE_UTIL_CRC_SLICES_USER
+// to 1, 4 or 8.
+// All functions take the CRC of the data processed so far so that the data can be
+// processed in blocks: initial value is 0 for both CRCs.
+
+#ifdef CORE_UTIL_CRC_SLICES_USER
+#define CORE_UTIL_CRC_SLICES CORE_UTIL_CRC_SLICES_USER
+#elif defined(CORE_MCU_ARCH_AVR) && !defined(CORE_MCU_STUB)
+#define CORE_UTIL_CRC_SLICES 1
+#else
+#define CORE_UTIL_CRC_SLICES 4
+#endif
+
+namespace core::util::crc
+{
+    namespace detail
+    {
+        constexpr size_t SLICES = CORE_UTIL_CRC_SLICES;
+
+        static_assert((SLICES == 1) || (SLICES == 4) || (SLICES == 8), "Unsupported amount of CRC slices");
+
+        template<typename T>
+        using table_t = std::array<std::array<T, 256>, SLICES>;
+
+        constexpr table_t<uint16_t> makeXmodemTable()
+        {
+            table_t<uint16_t> table = {};
+
+            for (size_t i = 0; i < 256; i++)
+            {
+                uint16_t crc = i << 8;
+
+                for (size_t bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+                }
+
+                table[0][i] = crc;
+            }
+
+            for (size_t slice = 1; slice < SLICES; slice++)
+            {
+                for (size_t i = 0; i < 256; i++)
+                {
+                    const uint16_t PREVIOUS = table[slice - 1][i];
+                    table[slice][i]         = (PREVIOUS << 8) ^ table[0][PREVIOUS >> 8];
+                }
+            }
+
+            return table;
+        }
+
+        constexpr table_t<uint32_t> makeCrc32Table()
+        {
+            table_t<uint32_t> table = {};
+
+            for (size_t i = 0; i < 256; i++)
+            {
+                uint32_t crc = i;
+
+                for (size_t bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+                }
+
+                table[0][i] = crc;
+            }
+
+            for (size_t slice = 1; slice < SLICES; slice++)
+            {
+                for (size_t i = 0; i < 256; i++)
+                {
+                    const uint32_t PREVIOUS = table[slice - 1][i];
+                    table[slice][i]         = (PREVIOUS >> 8) ^ table[0][PREVIOUS & 0xFF];
+                }
+            }
+
+            return table;
+        }
+
+        inline constexpr table_t<uint16_t> XMODEM_TABLE PROGMEM = makeXmodemTable();
+        inline constexpr table_t<uint32_t> CRC32_TABLE PROGMEM  = makeCrc32Table();
+
+        inline uint16_t xmodemEntry(size_t slice, uint8_t index)
+        {
+            return CORE_UTIL_READ_PROGMEM_WORD(XMODEM_TABLE[slice][index]);
+        }
+
+        inline uint32_t crc32Entry(size_t slice, uint8_t index)
+        {
+            return CORE_UTIL_READ_PROGMEM_DWORD(CRC32_TABLE[slice][index]);
+        }
+
+        /// Updates running (non-inverted) CRC-32 value with provided data.
+        inline uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size)
+        {
+            if constexpr (SLICES > 1)
+            {
+                for (; size >= SLICES; size -= SLICES, data += SLICES)
+                {
+                    const uint32_t WORD = crc ^ (static_cast<uint32_t>(data[0]) |
+                                                 static_cast<uint32_t>(data[1]) << 8 |
+                                                 static_cast<uint32_t>(data[2]) << 16 |
+                                                 static_cast<uint32_t>(data[3]) << 24);
+
+                    crc = 0;
+
+                    for (size_t i = 0; i < 4; i++)
+                    {
+                        crc ^= crc32Entry(SLICES - 1 - i, WORD >> (i * 8) & 0xFF);
+                    }
+
+                    for (size_t i = 4; i < SLICES; i++)
+                    {
+                        crc ^= crc32Entry(SLICES - 1 - i, data[i]);
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < size; i++)
+            {
+                crc = (crc >> 8) ^ crc32Entry(0, (crc ^ data[i]) & 0xFF);
+            }
+
+            return crc;
+        }
+    }    // namespace detail
+
+    /// Updates CRC-16/XMODEM with provided block of data.
+    /// param [in]: crc     CRC of the data processed so far (0 initially).
+    /// param [in]: data    Pointer to data.
+    /// param [in]: size    Amount of bytes to process.
+    /// returns: Updated CRC.
+    inline uint16_t xmodem(uint16_t crc, const uint8_t* data, size_t size)
+    {
+        using namespace detail;
+
+        if constexpr (SLICES > 1)
+        {
+            for (; size >= SLICES; size -= SLICES, data += SLICES)
+            {
+                const uint16_t FIRST = crc ^ (static_cast<uint16_t>(data[0]) << 8 | data[1]);
+
+                crc = xmodemEntry(SLICES - 1, FIRST >> 8) ^ xmodemEntry(SLICES - 2, FIRST & 0xFF);
+
+                for (size_t i = 2; i < SLICES; i++)
+                {
+                    crc ^= xmodemEntry(SLICES - 1 - i, data[i]);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < size; i++)
+        {
+            crc = (crc << 8) ^ xmodemEntry(0, (crc >> 8) ^ data[i]);
+        }
+
+        return crc;
+    }
+
+    inline uint16_t xmodem(uint16_t crc, uint8_t data)
+    {
+        return xmodem(crc, &data, 1);
+    }
+
+    /// Updates CRC-16/XMODEM with contiguous container of bytes (std::array, std::vector etc.).
+    template<typename T>
+    uint16_t xmodem(uint16_t crc, const T& data)
+    {
+        return xmodem(crc, reinterpret_cast<const uint8_t*>(data.data()), data.size() * sizeof(*data.data()));
+    }
+
+    /// Updates CRC-32 with provided block of data.
+    /// param [in]: crc     CRC of the data processed so far (0 initially).
+    /// param [in]: data    Pointer to data.
+    /// param [in]: size    Amount of bytes to process.
+    /// returns: Updated CRC.
+    inline uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size)
+    {
+        crc = ~crc;
+
+#ifdef CORE_UTIL_CRC32_HW
+        // hardware unit always starts from the initial value
+        if (crc == 0xFFFFFFFF)
+        {
+            const size_t WORDS = size / sizeof(uint32_t);
+
+            if (WORDS)
+            {
+                crc = hw::crc32(data, WORDS);
+                data += WORDS * sizeof(uint32_t);
+                size -= WORDS * sizeof(uint32_t);
+            }
+        }
+#endif
+
+        return ~detail::crc32Update(crc, data, size);
+    }
+
+    inline uint32_t crc32(uint32_t crc, uint8_t data)
+    {
+        return crc32(crc, &data, 1);
+    }
+
+    /// Updates CRC-32 with contiguous container of bytes (std::array, std::vector etc.).
+    template<typename T>
+    uint32_t crc32(uint32_t crc, const T& data)
+    {
+        return crc32(crc, reinterpret_cast<const uint8_t*>(data.data()), data.size() * sizeof(*data.data()));
+    }
+}    // namespace core::util::crc
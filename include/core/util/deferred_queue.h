@@ -0,0 +1,257 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "core/mcu.h"
+#include "core/util/handler.h"
+
+#if !defined(CORE_MCU_STUB) && (defined(CORE_MCU_ARCH_AVR) || defined(CORE_MCU_VENDOR_RPF))
+#define CORE_UTIL_DEFERRED_QUEUE_CRITICAL_SECTION
+#else
+#include <atomic>
+#endif
+
+namespace core::util
+{
+    /// Fixed-size queue of calls posted from interrupt context and run from the main loop.
+    /// Any amount of producers, running at any interrupt priority, can post to the queue
+    /// without locking: a slot is reserved by advancing the write position with compare-and-swap
+    /// and published by updating its sequence number once the call is stored. Single consumer
+    /// runs the published calls in order.
+    /// Posting also calls core::mcu::wake() so that the main loop doesn't go to sleep with
+    /// calls pending. Typical main loop:
+    ///
+    ///     queue.drain(budgetUs);
+    ///     scheduler.update(...);
+    ///
+    ///     if (!queue.isPending())
+    ///     {
+    ///         core::mcu::idle(scheduler deadline);
+    ///     }
+    ///
+    /// Tasks of core::util::Scheduler aren't safe to start or stop from interrupt context:
+    /// instead, post Handler<void()>::bind<Task, &Task::start>(task).
+    template<size_t size>
+    class DeferredQueue
+    {
+        static_assert(size > 1 && !(size & (size - 1)), "Deferred queue size must be a power of two and larger than 1.");
+
+        public:
+        using handler_t = Handler<void()>;
+
+        DeferredQueue()
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                _slots[i].sequence.store(i);
+            }
+        }
+
+        DeferredQueue(const DeferredQueue&)            = delete;
+        DeferredQueue& operator=(const DeferredQueue&) = delete;
+
+        /// Queues the call. Safe to use from any context.
+        /// returns: False if the queue is full or the handler is empty, true otherwise.
+        bool post(handler_t handler)
+        {
+            if (!handler)
+            {
+                return false;
+            }
+
+            uint32_t position = _writePosition.loadRelaxed();
+            Slot*    slot     = nullptr;
+
+            while (true)
+            {
+                slot                     = &_slots[position & MASK];
+                const int32_t DIFFERENCE = static_cast<int32_t>(slot->sequence.load() - position);
+
+                if (DIFFERENCE == 0)
+                {
+                    // slot is free: claim it unless another producer has been faster
+                    if (_writePosition.compareExchange(position, position + 1))
+                    {
+                        break;
+                    }
+                }
+                else if (DIFFERENCE < 0)
+                {
+                    // slot still holds the call which hasn't been run yet
+                    return false;
+                }
+                else
+                {
+                    position = _writePosition.loadRelaxed();
+                }
+            }
+
+            slot->handler = handler;
+            slot->sequence.store(position + 1);
+
+            core::mcu::wake();
+
+            return true;
+        }
+
+        /// Runs the queued calls in order. Stops once the queue is empty or, if budgetUs
+        /// isn't 0, once the calls have been running for at least budgetUs. At least one
+        /// queued call is always run. Needs to be called from single context only.
+        /// returns: Amount of calls which have been run.
+        size_t drain(uint32_t budgetUs = 0)
+        {
+            const uint32_t START = budgetUs ? core::mcu::timing::us() : 0;
+            size_t         total = 0;
+
+            while (true)
+            {
+                Slot& slot = _slots[_readPosition & MASK];
+
+                if (slot.sequence.load() != (_readPosition + 1))
+                {
+                    // empty, or the producer which has reserved the slot hasn't published it yet
+                    break;
+                }
+
+                handler_t handler = slot.handler;
+
+                // release the slot before running so that the handler can post again
+                slot.sequence.store(_readPosition + size);
+                _readPosition++;
+
+                handler();
+                total++;
+
+                if (budgetUs && ((core::mcu::timing::us() - START) >= budgetUs))
+                {
+                    break;
+                }
+            }
+
+            return total;
+        }
+
+        /// Checks whether there is a call ready to be run.
+        /// Needs to be called from the same context as drain().
+        bool isPending() const
+        {
+            return _slots[_readPosition & MASK].sequence.load() == (_readPosition + 1);
+        }
+
+        private:
+        /// Position or sequence number shared between the contexts.
+        class Counter
+        {
+            public:
+#ifdef CORE_UTIL_DEFERRED_QUEUE_CRITICAL_SECTION
+            // no compare-and-swap instructions (AVR, Cortex-M0+): interrupts are disabled
+            // for the duration of a single access instead, which also guards 32-bit
+            // accesses against tearing on AVR
+            uint32_t load() const
+            {
+                uint32_t value;
+
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    value = _value;
+                }
+
+                return value;
+            }
+
+            uint32_t loadRelaxed() const
+            {
+                return load();
+            }
+
+            void store(uint32_t value)
+            {
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    _value = value;
+                }
+            }
+
+            bool compareExchange(uint32_t& expected, uint32_t desired)
+            {
+                bool exchanged = false;
+
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    if (_value == expected)
+                    {
+                        _value    = desired;
+                        exchanged = true;
+                    }
+                    else
+                    {
+                        expected = _value;
+                    }
+                }
+
+                return exchanged;
+            }
+
+            private:
+            volatile uint32_t _value = 0;
+#else
+            uint32_t load() const
+            {
+                return _value.load(std::memory_order_acquire);
+            }
+
+            uint32_t loadRelaxed() const
+            {
+                return _value.load(std::memory_order_relaxed);
+            }
+
+            void store(uint32_t value)
+            {
+                _value.store(value, std::memory_order_release);
+            }
+
+            bool compareExchange(uint32_t& expected, uint32_t desired)
+            {
+                return _value.compare_exchange_weak(expected, desired, std::memory_order_relaxed);
+            }
+
+            private:
+            std::atomic<uint32_t> _value = { 0 };
+#endif
+        };
+
+        struct Slot
+        {
+            Counter   sequence;
+            handler_t handler;
+        };
+
+        static constexpr uint32_t MASK = size - 1;
+
+        Slot     _slots[size];
+        Counter  _writePosition;
+        uint32_t _readPosition = 0;
+    };
+}    // namespace core::util
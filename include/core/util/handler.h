@@ -0,0 +1,110 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace core::util
+{
+    template<typename>
+    class Handler;
+
+    /// Non-owning callable made of function pointer and context pointer.
+    /// Unlike std::function, it never allocates and calling it is single indirect call.
+    /// The functions bound with bind() are known at compile time, so the generated
+    /// trampolines call them directly and can inline them.
+    template<typename R, typename... Args>
+    class Handler<R(Args...)>
+    {
+        public:
+        using func_t = R (*)(void* context, Args... args);
+
+        constexpr Handler() = default;
+
+        constexpr Handler(std::nullptr_t)
+        {}
+
+        constexpr Handler(func_t func, void* context)
+            : _func(func)
+            , _context(context)
+        {}
+
+        /// Wraps plain function pointer or lambda without captures.
+        template<typename F,
+                 typename = std::enable_if_t<std::is_convertible_v<F, R (*)(Args...)>>>
+        Handler(F function)
+            : _func([](void* context, Args... args) -> R
+                    {
+                        return reinterpret_cast<R (*)(Args...)>(context)(args...);
+                    })
+            , _context(reinterpret_cast<void*>(static_cast<R (*)(Args...)>(function)))
+        {}
+
+        /// Binds free function known at compile time.
+        template<R (*function)(Args...)>
+        static constexpr Handler bind()
+        {
+            return Handler([](void*, Args... args) -> R
+                           {
+                               return function(args...);
+                           },
+                           nullptr);
+        }
+
+        /// Binds member function known at compile time to the provided object.
+        template<typename T, R (T::*method)(Args...)>
+        static constexpr Handler bind(T& object)
+        {
+            return Handler([](void* context, Args... args) -> R
+                           {
+                               return (static_cast<T*>(context)->*method)(args...);
+                           },
+                           &object);
+        }
+
+        R operator()(Args... args) const
+        {
+            return _func(_context, args...);
+        }
+
+        explicit operator bool() const
+        {
+            return _func != nullptr;
+        }
+
+        bool operator==(std::nullptr_t) const
+        {
+            return _func == nullptr;
+        }
+
+        bool operator!=(std::nullptr_t) const
+        {
+            return _func != nullptr;
+        }
+
+        private:
+        func_t _func    = nullptr;
+        void*  _context = nullptr;
+    };
+}    // namespace core::util
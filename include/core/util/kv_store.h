@@ -0,0 +1,492 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <array>
+#include "core/arch/common/flash.h"
+#include "core/util/util.h"
+#include "core/util/crc.h"
+
+namespace core::util
+{
+    /// Log-structured key-value store on top of MCU flash, intended for EEPROM emulation.
+    /// Each write appends a record to the newest flash page, so pages are erased only once
+    /// they are full and their up-to-date records have been moved elsewhere. Pages are used
+    /// in round-robin fashion to even out the wear. RAM index holds the location of the
+    /// latest record for each key.
+    /// Garbage collection is incremental: update() needs to be called periodically so that
+    /// the live records from the oldest page are moved a few at a time and the page itself
+    /// is erased in a separate call. Write blocks on garbage collection only if update()
+    /// hasn't been called often enough.
+    ///
+    /// Page layout: header word (MAGIC << 16 | sequence), unused word, records.
+    /// Record layout: header word (checksum << 16 | key), value word. Value is written
+    /// first and the checksum covers both words, so interrupted write is detected on init.
+    template<size_t pageCount, size_t maxKeys>
+    class KvStore
+    {
+        static_assert(pageCount >= 2, "At least two flash pages are required");
+        static_assert(maxKeys <= 0xFFFF, "Key needs to fit into 16 bits");
+
+        public:
+        struct stats_t
+        {
+            size_t writes   = 0;    ///< Records written through write().
+            size_t gcWrites = 0;    ///< Records moved by garbage collection.
+            size_t erases   = 0;    ///< Erased pages.
+        };
+
+        /// param [in]: pages   Indexes of flash pages used by the store.
+        ///                     Each page needs to be able to hold maxKeys + 1 records.
+        KvStore(const std::array<size_t, pageCount>& pages)
+            : _pages(pages)
+        {}
+
+        /// Rebuilds the index from flash contents and recovers from interrupted writes,
+        /// garbage collection or erase. Flash is formatted if it doesn't hold any valid data.
+        /// returns: True on success, false if the provided pages are too small.
+        bool init()
+        {
+            for (size_t i = 0; i < pageCount; i++)
+            {
+                if (slots(i) < (maxKeys + 2))
+                {
+                    return false;
+                }
+            }
+
+            bool     active[pageCount] = {};
+            uint16_t sequence[pageCount];
+            bool     anyActive = false;
+
+            for (size_t i = 0; i < pageCount; i++)
+            {
+                uint32_t header = read32(pageAddress(i));
+
+                if ((header >> 16) == MAGIC)
+                {
+                    active[i]   = true;
+                    sequence[i] = header & 0xFFFF;
+                    anyActive   = true;
+                }
+                else if ((header != ERASED) || !isErased(i))
+                {
+                    // interrupted erase
+                    erase(i);
+                }
+            }
+
+            if (!anyActive)
+            {
+                return format();
+            }
+
+            // the oldest page is the one which doesn't continue the sequence of its predecessor
+            _tail = 0;
+
+            for (size_t i = 0; i < pageCount; i++)
+            {
+                auto previous = (i + pageCount - 1) % pageCount;
+
+                if (active[i] && (!active[previous] || (static_cast<uint16_t>(sequence[previous] + 1) != sequence[i])))
+                {
+                    _tail = i;
+                    break;
+                }
+            }
+
+            _index.fill(NO_RECORD);
+            _head        = _tail;
+            _activePages = 1;
+            replay(_tail);
+
+            for (auto position = next(_head);
+                 (position != _tail) && active[position] && (sequence[position] == static_cast<uint16_t>(sequence[_head] + 1));
+                 position = next(_head))
+            {
+                _head = position;
+                _activePages++;
+                replay(_head);
+            }
+
+            _headSequence = sequence[_head];
+
+            // anything active outside of the chain is stale
+            for (size_t i = 0, position = next(_head); i < erasedPages(); i++, position = next(position))
+            {
+                if (active[position])
+                {
+                    erase(position);
+                }
+            }
+
+            _gcPending = false;
+
+            if (!erasedPages())
+            {
+                startGc();
+            }
+
+            return true;
+        }
+
+        /// Erases all the pages and starts over with empty store.
+        bool format()
+        {
+            for (size_t i = 0; i < pageCount; i++)
+            {
+                erase(i);
+            }
+
+            _index.fill(NO_RECORD);
+            _tail         = 0;
+            _head         = 0;
+            _activePages  = 1;
+            _headSequence = 0;
+            _gcPending    = false;
+
+            return activate(_head);
+        }
+
+        /// Reads the latest value for specified key.
+        /// returns: True if the value exists, false otherwise.
+        bool read(uint16_t key, uint32_t& value)
+        {
+            if ((key >= maxKeys) || (_index[key] == NO_RECORD))
+            {
+                return false;
+            }
+
+            value = read32(_index[key] + sizeof(uint32_t));
+            return true;
+        }
+
+        /// Writes new value for specified key.
+        /// Nothing is written if the value is already stored.
+        /// returns: True on success, false otherwise.
+        bool write(uint16_t key, uint32_t value)
+        {
+            if (key >= maxKeys)
+            {
+                return false;
+            }
+
+            uint32_t current = 0;
+
+            if (read(key, current) && (current == value))
+            {
+                return true;
+            }
+
+            if (_gcPending)
+            {
+                // keep enough space in the newest page for the records which still need to be moved
+                size_t needed = _gcRemaining + (isInPage(_index[key], _tail) ? 0 : 1);
+
+                if (freeSlots() < needed)
+                {
+                    finishGc();
+                }
+            }
+
+            if (!freeSlots())
+            {
+                finishGc();
+
+                if (!advance())
+                {
+                    return false;
+                }
+            }
+
+            if (!append(key, value))
+            {
+                return false;
+            }
+
+            _stats.writes++;
+            return true;
+        }
+
+        /// Performs single step of garbage collection: moves up to GC_RECORDS_PER_STEP live
+        /// records out of the oldest page, or erases the oldest page once it holds no live records.
+        /// returns: True if more garbage collection steps are pending, false if there is nothing
+        ///          to collect or if moving the record has failed.
+        bool update()
+        {
+            if (!_gcPending)
+            {
+                return false;
+            }
+
+            if (_gcRemaining)
+            {
+                size_t moved = 0;
+
+                while ((_gcKey < maxKeys) && (moved < GC_RECORDS_PER_STEP))
+                {
+                    if (isInPage(_index[_gcKey], _tail))
+                    {
+                        if (!append(_gcKey, read32(_index[_gcKey] + sizeof(uint32_t))))
+                        {
+                            return false;
+                        }
+
+                        _stats.gcWrites++;
+                        moved++;
+                    }
+
+                    _gcKey++;
+                }
+
+                return true;
+            }
+
+            erase(_tail);
+            _tail = next(_tail);
+            _activePages--;
+            _gcPending = false;
+
+            return false;
+        }
+
+        /// Returns the statistics used to evaluate write amplification: (writes + gcWrites) / writes.
+        stats_t stats() const
+        {
+            return _stats;
+        }
+
+        static constexpr size_t GC_RECORDS_PER_STEP = 8;
+
+        private:
+        static constexpr uint16_t MAGIC       = 0x4B56;
+        static constexpr uint32_t ERASED      = 0xFFFFFFFF;
+        static constexpr uint32_t NO_RECORD   = 0;
+        static constexpr size_t   RECORD_SIZE = 2 * sizeof(uint32_t);
+
+        const std::array<size_t, pageCount> _pages;
+        std::array<uint32_t, maxKeys>       _index        = {};
+        size_t                              _tail         = 0;
+        size_t                              _head         = 0;
+        size_t                              _activePages  = 0;
+        size_t                              _writeSlot    = 0;
+        uint16_t                            _headSequence = 0;
+        bool                                _gcPending    = false;
+        size_t                              _gcKey        = 0;
+        size_t                              _gcRemaining  = 0;
+        stats_t                             _stats;
+
+        size_t next(size_t position) const
+        {
+            return (position + 1) % pageCount;
+        }
+
+        uint32_t pageAddress(size_t position) const
+        {
+            return core::mcu::flash::pageAddress(_pages[position]);
+        }
+
+        size_t slots(size_t position) const
+        {
+            return core::mcu::flash::pageSize(_pages[position]) / RECORD_SIZE;
+        }
+
+        size_t erasedPages() const
+        {
+            return pageCount - _activePages;
+        }
+
+        size_t freeSlots() const
+        {
+            return slots(_head) - _writeSlot;
+        }
+
+        bool isInPage(uint32_t address, size_t position) const
+        {
+            return (address != NO_RECORD) &&
+                   (address >= pageAddress(position)) &&
+                   (address < (pageAddress(position) + (slots(position) * RECORD_SIZE)));
+        }
+
+        uint32_t read32(uint32_t address) const
+        {
+            uint32_t data = ERASED;
+            core::mcu::flash::read32(address, data);
+            return data;
+        }
+
+        static uint16_t checksum(uint16_t key, uint32_t value)
+        {
+            const uint8_t DATA[] = {
+                static_cast<uint8_t>(key & 0xFF),
+                static_cast<uint8_t>(key >> 8),
+                static_cast<uint8_t>(value & 0xFF),
+                static_cast<uint8_t>(value >> 8 & 0xFF),
+                static_cast<uint8_t>(value >> 16 & 0xFF),
+                static_cast<uint8_t>(value >> 24 & 0xFF),
+            };
+
+            return core::util::crc::xmodem(0, DATA, sizeof(DATA));
+        }
+
+        bool isErased(size_t position) const
+        {
+            for (uint32_t address = pageAddress(position); address < (pageAddress(position) + core::mcu::flash::pageSize(_pages[position])); address += sizeof(uint32_t))
+            {
+                if (read32(address) != ERASED)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void erase(size_t position)
+        {
+            core::mcu::flash::erasePage(_pages[position]);
+            _stats.erases++;
+        }
+
+        /// Indexes all valid records from specified page and sets the write position after the last used slot.
+        void replay(size_t position)
+        {
+            _writeSlot = 1;
+
+            for (size_t slot = 1; slot < slots(position); slot++)
+            {
+                const uint32_t ADDRESS = pageAddress(position) + (slot * RECORD_SIZE);
+                const uint32_t HEADER  = read32(ADDRESS);
+                const uint32_t VALUE   = read32(ADDRESS + sizeof(uint32_t));
+
+                if ((HEADER == ERASED) && (VALUE == ERASED))
+                {
+                    continue;
+                }
+
+                // slot is used even if the record is corrupted
+                _writeSlot = slot + 1;
+
+                const uint16_t KEY = HEADER & 0xFFFF;
+
+                if ((KEY < maxKeys) && ((HEADER >> 16) == checksum(KEY, VALUE)))
+                {
+                    _index[KEY] = ADDRESS;
+                }
+            }
+        }
+
+        bool activate(size_t position)
+        {
+            _writeSlot = 1;
+
+            if (!core::mcu::flash::write32(pageAddress(position), (static_cast<uint32_t>(MAGIC) << 16) | _headSequence))
+            {
+                return false;
+            }
+
+            return core::mcu::flash::flush();
+        }
+
+        /// Moves the writing to the next erased page.
+        bool advance()
+        {
+            if (!erasedPages())
+            {
+                return false;
+            }
+
+            _head = next(_head);
+            _headSequence++;
+            _activePages++;
+
+            if (!activate(_head))
+            {
+                return false;
+            }
+
+            if (!erasedPages())
+            {
+                startGc();
+            }
+
+            return true;
+        }
+
+        bool append(uint16_t key, uint32_t value)
+        {
+            const uint32_t ADDRESS = pageAddress(_head) + (_writeSlot * RECORD_SIZE);
+
+            // slot is considered used even if the write fails
+            _writeSlot++;
+
+            if (!core::mcu::flash::write32(ADDRESS + sizeof(uint32_t), value))
+            {
+                return false;
+            }
+
+            if (!core::mcu::flash::write32(ADDRESS, (static_cast<uint32_t>(checksum(key, value)) << 16) | key))
+            {
+                return false;
+            }
+
+            if (!core::mcu::flash::flush())
+            {
+                return false;
+            }
+
+            if (_gcPending && isInPage(_index[key], _tail))
+            {
+                _gcRemaining--;
+            }
+
+            _index[key] = ADDRESS;
+            return true;
+        }
+
+        void startGc()
+        {
+            _gcPending   = true;
+            _gcKey       = 0;
+            _gcRemaining = 0;
+
+            for (size_t i = 0; i < maxKeys; i++)
+            {
+                if (isInPage(_index[i], _tail))
+                {
+                    _gcRemaining++;
+                }
+            }
+        }
+
+        void finishGc()
+        {
+            while (update())
+            {
+                ;
+            }
+        }
+    };
+}    // namespace core::util
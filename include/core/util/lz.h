@@ -0,0 +1,331 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "core/util/crc.h"
+
+// LZ77 compression with small, fixed window, suitable for streaming the data into
+// MCUs with little RAM (firmware updates). Format follows LZ4 block format: every
+// sequence starts with token byte holding literal length in upper and match length
+// (minus MIN_MATCH) in lower nibble, with value of 15 in either nibble being extended
+// by additional bytes (255 meaning another byte follows). Token and optional literal
+// length bytes are followed by literals and two-byte little-endian match offset, and
+// optional match length bytes. Last sequence holds only literals.
+// Sequences are preceded by the decoded length and followed by CRC-32 of the decoded
+// data (both 4 bytes, little-endian), so that truncated or damaged stream is detected.
+// Decoder never refers further back than windowSize bytes, so encoder and decoder
+// need to use the same window size. Host-side encoder is in core/util/lz_encoder.h.
+
+namespace core::util::lz
+{
+    constexpr size_t MIN_MATCH    = 4;
+    constexpr size_t HEADER_SIZE  = 4;
+    constexpr size_t TRAILER_SIZE = 4;
+
+    /// Incremental decoder: compressed data can be provided in blocks of any size.
+    /// RAM usage is limited to the window.
+    template<size_t windowSize>
+    class Decoder
+    {
+        static_assert(windowSize && !(windowSize & (windowSize - 1)), "Window size needs to be power of two");
+        static_assert(windowSize <= 0xFFFF, "Window size needs to fit into 16-bit offset");
+
+        public:
+        Decoder() = default;
+
+        /// Decodes provided block of compressed data.
+        /// param [in]: data        Pointer to compressed data.
+        /// param [in]: size        Amount of bytes in provided block.
+        /// param [in]: handler     Callable with (const uint8_t* data, size_t size) signature, returning bool,
+        ///                         used to pass on decoded data.
+        /// returns: False if the stream is corrupted or if the handler has failed, true otherwise.
+        template<typename Handler>
+        bool decode(const uint8_t* data, size_t size, Handler&& handler)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                const uint8_t BYTE = data[i];
+
+                switch (_state)
+                {
+                case state_t::HEADER:
+                {
+                    _length |= static_cast<uint32_t>(BYTE) << (_fieldBytes * 8);
+
+                    if (++_fieldBytes == HEADER_SIZE)
+                    {
+                        _fieldBytes = 0;
+                        _state      = state_t::TOKEN;
+                    }
+                }
+                break;
+
+                case state_t::TOKEN:
+                {
+                    _literalLength = BYTE >> 4;
+                    _matchLength   = BYTE & 0x0F;
+
+                    if (_literalLength == 15)
+                    {
+                        _state = state_t::LITERAL_LENGTH;
+                    }
+                    else if (_literalLength)
+                    {
+                        _state = state_t::LITERALS;
+                    }
+                    else
+                    {
+                        afterLiterals();
+                    }
+                }
+                break;
+
+                case state_t::LITERAL_LENGTH:
+                {
+                    _literalLength += BYTE;
+
+                    if (BYTE != 255)
+                    {
+                        _state = state_t::LITERALS;
+                    }
+                }
+                break;
+
+                case state_t::LITERALS:
+                {
+                    // copy as much as possible at once
+                    size_t count = size - i;
+
+                    if (count > _literalLength)
+                    {
+                        count = _literalLength;
+                    }
+
+                    for (size_t j = 0; j < count; j++)
+                    {
+                        if (!put(data[i + j], handler))
+                        {
+                            return false;
+                        }
+                    }
+
+                    i += count - 1;
+                    _literalLength -= count;
+
+                    if (!_literalLength)
+                    {
+                        afterLiterals();
+                    }
+                }
+                break;
+
+                case state_t::OFFSET_LOW:
+                {
+                    _offset = BYTE;
+                    _state  = state_t::OFFSET_HIGH;
+                }
+                break;
+
+                case state_t::OFFSET_HIGH:
+                {
+                    _offset |= static_cast<uint32_t>(BYTE) << 8;
+
+                    if (!_offset || (_offset > windowSize) || (_offset > _total))
+                    {
+                        return false;
+                    }
+
+                    if (_matchLength == 15)
+                    {
+                        _state = state_t::MATCH_LENGTH;
+                    }
+                    else if (!copyMatch(handler))
+                    {
+                        return false;
+                    }
+                }
+                break;
+
+                case state_t::MATCH_LENGTH:
+                {
+                    _matchLength += BYTE;
+
+                    if ((BYTE != 255) && !copyMatch(handler))
+                    {
+                        return false;
+                    }
+                }
+                break;
+
+                case state_t::TRAILER:
+                {
+                    _expectedCrc |= static_cast<uint32_t>(BYTE) << (_fieldBytes * 8);
+
+                    if (++_fieldBytes == TRAILER_SIZE)
+                    {
+                        // CRC covers all the data, so everything needs to be passed on first
+                        if (!emit(handler) || (_crc != _expectedCrc))
+                        {
+                            return false;
+                        }
+
+                        _state = state_t::DONE;
+                    }
+                }
+                break;
+
+                default:
+                    // no data is expected once the stream is complete
+                    return false;
+                }
+            }
+
+            return emit(handler);
+        }
+
+        /// Checks whether the entire stream has been decoded: the amount of decoded bytes matches
+        /// the one from the header and CRC of the decoded data has been verified.
+        bool isComplete() const
+        {
+            return _state == state_t::DONE;
+        }
+
+        /// Returns the total amount of decoded bytes.
+        uint32_t total() const
+        {
+            return _total;
+        }
+
+        void reset()
+        {
+            _state       = state_t::HEADER;
+            _fieldBytes  = 0;
+            _length      = 0;
+            _expectedCrc = 0;
+            _crc         = 0;
+            _total       = 0;
+            _emitted     = 0;
+        }
+
+        private:
+        enum class state_t : uint8_t
+        {
+            HEADER,
+            TOKEN,
+            LITERAL_LENGTH,
+            LITERALS,
+            OFFSET_LOW,
+            OFFSET_HIGH,
+            MATCH_LENGTH,
+            TRAILER,
+            DONE,
+        };
+
+        static constexpr size_t MASK = windowSize - 1;
+
+        uint8_t  _window[windowSize] = {};
+        state_t  _state              = state_t::HEADER;
+        uint8_t  _fieldBytes         = 0;
+        uint32_t _length             = 0;
+        uint32_t _expectedCrc        = 0;
+        uint32_t _crc                = 0;
+        uint32_t _literalLength      = 0;
+        uint32_t _matchLength        = 0;
+        uint32_t _offset             = 0;
+        uint32_t _total              = 0;    ///< Position in decoded stream: 32-bit so that images over 64 KiB work on AVR too.
+        uint32_t _emitted            = 0;
+
+        /// Once all the data from the header has been decoded, only the last sequence
+        /// (without match) can end here.
+        void afterLiterals()
+        {
+            _state = (_total == _length) ? state_t::TRAILER : state_t::OFFSET_LOW;
+        }
+
+        /// Stores decoded byte into the window. Data which hasn't been passed on yet is emitted
+        /// before it gets overwritten.
+        template<typename Handler>
+        bool put(uint8_t data, Handler&& handler)
+        {
+            if (_total == _length)
+            {
+                return false;
+            }
+
+            if ((_total - _emitted) == windowSize)
+            {
+                if (!emit(handler))
+                {
+                    return false;
+                }
+            }
+
+            _window[static_cast<size_t>(_total++ & MASK)] = data;
+            return true;
+        }
+
+        template<typename Handler>
+        bool copyMatch(Handler&& handler)
+        {
+            for (uint32_t i = 0; i < (_matchLength + MIN_MATCH); i++)
+            {
+                if (!put(_window[static_cast<size_t>((_total - _offset) & MASK)], handler))
+                {
+                    return false;
+                }
+            }
+
+            _state = state_t::TOKEN;
+            return true;
+        }
+
+        /// Passes on all the decoded data which hasn't been passed on yet, in at most two blocks.
+        template<typename Handler>
+        bool emit(Handler&& handler)
+        {
+            while (_emitted != _total)
+            {
+                const size_t START = static_cast<size_t>(_emitted & MASK);
+                size_t       count = static_cast<size_t>(_total - _emitted);
+
+                if (count > (windowSize - START))
+                {
+                    count = windowSize - START;
+                }
+
+                if (!handler(&_window[START], count))
+                {
+                    return false;
+                }
+
+                _crc = core::util::crc::crc32(_crc, &_window[START], count);
+
+                _emitted += count;
+            }
+
+            return true;
+        }
+    };
+}    // namespace core::util::lz
@@ -0,0 +1,184 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+#include "core/util/crc.h"
+#include "core/util/lz.h"
+
+// Host-side counterpart of core::util::lz::Decoder, used to prepare compressed
+// firmware images. Not meant to be used on MCUs.
+
+namespace core::util::lz
+{
+    /// Host-side encoder producing the stream for Decoder with the same window size.
+    template<size_t windowSize>
+    class Encoder
+    {
+        static_assert(windowSize && !(windowSize & (windowSize - 1)), "Window size needs to be power of two");
+        static_assert(windowSize <= 0xFFFF, "Window size needs to fit into 16-bit offset");
+
+        public:
+        /// Compresses provided data.
+        /// param [in]: data    Pointer to data to compress.
+        /// param [in]: size    Amount of bytes to compress.
+        /// returns: Compressed stream, including the header and the trailer.
+        static std::vector<uint8_t> encode(const uint8_t* data, size_t size)
+        {
+            std::vector<uint8_t> out;
+            std::vector<size_t>  head(HASH_SIZE, NO_POSITION);
+            std::vector<size_t>  chain(windowSize, NO_POSITION);
+
+            writeWord(out, size);
+
+            size_t literalStart = 0;
+            size_t pos          = 0;
+
+            auto insert = [&](size_t position)
+            {
+                if ((position + MIN_MATCH) <= size)
+                {
+                    const size_t KEY                    = hash(&data[position]);
+                    chain[position & (windowSize - 1)] = head[KEY];
+                    head[KEY]                           = position;
+                }
+            };
+
+            while ((pos + MIN_MATCH) <= size)
+            {
+                size_t bestLength = 0;
+                size_t bestOffset = 0;
+                size_t candidate  = head[hash(&data[pos])];
+
+                for (size_t attempt = 0; (attempt < MAX_CHAIN) && (candidate != NO_POSITION) && ((pos - candidate) <= windowSize); attempt++)
+                {
+                    size_t length = 0;
+
+                    while (((pos + length) < size) && (data[candidate + length] == data[pos + length]))
+                    {
+                        length++;
+                    }
+
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestOffset = pos - candidate;
+                    }
+
+                    size_t next = chain[candidate & (windowSize - 1)];
+
+                    if ((next == NO_POSITION) || (next >= candidate))
+                    {
+                        break;
+                    }
+
+                    candidate = next;
+                }
+
+                if (bestLength < MIN_MATCH)
+                {
+                    insert(pos++);
+                    continue;
+                }
+
+                writeSequence(out, &data[literalStart], pos - literalStart, bestOffset, bestLength);
+
+                for (size_t i = 0; i < bestLength; i++)
+                {
+                    insert(pos++);
+                }
+
+                literalStart = pos;
+            }
+
+            // the last sequence holds only literals
+            writeSequence(out, &data[literalStart], size - literalStart, 0, 0);
+            writeWord(out, core::util::crc::crc32(0, data, size));
+
+            return out;
+        }
+
+        private:
+        static constexpr size_t HASH_BITS   = 12;
+        static constexpr size_t HASH_SIZE   = 1 << HASH_BITS;
+        static constexpr size_t MAX_CHAIN   = 64;
+        static constexpr size_t NO_POSITION = static_cast<size_t>(-1);
+
+        static size_t hash(const uint8_t* data)
+        {
+            uint32_t value = 0;
+            memcpy(&value, data, sizeof(value));
+
+            return (value * 2654435761U) >> (32 - HASH_BITS);
+        }
+
+        static void writeWord(std::vector<uint8_t>& out, uint32_t value)
+        {
+            for (size_t i = 0; i < sizeof(value); i++)
+            {
+                out.push_back(value >> (i * 8));
+            }
+        }
+
+        static void writeLength(std::vector<uint8_t>& out, size_t length)
+        {
+            while (length >= 255)
+            {
+                out.push_back(255);
+                length -= 255;
+            }
+
+            out.push_back(length);
+        }
+
+        static void writeSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+        {
+            const size_t MATCH = matchLength ? (matchLength - MIN_MATCH) : 0;
+
+            out.push_back(((literalLength < 15 ? literalLength : 15) << 4) | (MATCH < 15 ? MATCH : 15));
+
+            if (literalLength >= 15)
+            {
+                writeLength(out, literalLength - 15);
+            }
+
+            out.insert(out.end(), literals, literals + literalLength);
+
+            if (!matchLength)
+            {
+                return;
+            }
+
+            out.push_back(offset & 0xFF);
+            out.push_back(offset >> 8);
+
+            if (MATCH >= 15)
+            {
+                writeLength(out, MATCH - 15);
+            }
+        }
+    };
+}    // namespace core::util::lz
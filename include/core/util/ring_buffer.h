@@ -24,9 +24,23 @@
 
 #include <inttypes.h>
 #include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+#if defined(CORE_MCU_ARCH_AVR) && !defined(CORE_MCU_STUB)
+#include "core/arch/avr/common/atomic.h"
+#else
+#include <atomic>
+#endif
 
 namespace core::util
 {
+    /// Fixed-size circular buffer.
+    /// Safe for use with single producer and single consumer running in different
+    /// contexts (eg. interrupt and main loop) without additional locking: head index
+    /// is written only by the producer, tail index only by the consumer. Each side
+    /// publishes its own index with release semantics and observes the other one with
+    /// acquire semantics.
     template<typename T, size_t maxSize>
     class RingBuffer
     {
@@ -37,66 +51,89 @@ namespace core::util
 
         static constexpr size_t BUFFER_SIZE = maxSize;
 
-        size_t size() const
+        /// Maximum amount of elements which can be stored in the buffer at once.
+        static constexpr size_t capacity()
         {
-            size_t   result   = 0;
-            uint16_t headCopy = _head;
-            uint16_t tailCopy = _tail;
+            return BUFFER_SIZE - 1;
+        }
 
-            if (headCopy >= tailCopy)
-            {
-                result = headCopy - tailCopy;
-            }
-            else
-            {
-                result = BUFFER_SIZE + headCopy - tailCopy;
-            }
+        size_t size() const
+        {
+            return (_head.load() - _tail.load()) & MASK;
+        }
 
-            return result;
+        /// Returns the amount of elements which can be inserted before the buffer becomes full.
+        size_t freeSpace() const
+        {
+            return capacity() - size();
         }
 
         bool isEmpty() const
         {
-            return _head == _tail;
+            return _head.load() == _tail.load();
         }
 
         bool isFull() const
         {
-            return size() == (BUFFER_SIZE - 1);
+            return size() == capacity();
         }
 
         bool insert(T data)
         {
-            const size_t NEXT = (_head + 1) & (BUFFER_SIZE - 1);
+            const size_t NEXT = (_head.loadRelaxed() + 1) & MASK;
 
             // avoid overflow - this would create empty buffer
-            if (_tail == NEXT)
+            if (_tail.load() == NEXT)
             {
                 return false;
             }
 
             _buffer[NEXT] = data;
-            _head         = NEXT;
+            _head.store(NEXT);
 
             return true;
         }
 
-        // get last element without removing it
-        bool peek(T& result)
+        /// Inserts as many elements from provided array as there is free space for.
+        /// Data is copied in at most two contiguous segments (before and after the wrap).
+        /// param [in]: data    Pointer to array holding elements to insert.
+        /// param [in]: size    Amount of elements in provided array.
+        /// returns: Amount of inserted elements.
+        size_t insert(const T* data, size_t size)
         {
-            if (isEmpty())
+            const size_t HEAD = _head.loadRelaxed();
+            const size_t FREE = capacity() - ((HEAD - _tail.load()) & MASK);
+
+            if (size > FREE)
             {
-                return false;
+                size = FREE;
             }
 
-            size_t next = _tail + 1;
+            if (!size)
+            {
+                return 0;
+            }
+
+            const size_t START = (HEAD + 1) & MASK;
+            const size_t FIRST = size < (BUFFER_SIZE - START) ? size : (BUFFER_SIZE - START);
+
+            copy(&_buffer[START], data, FIRST);
+            copy(&_buffer[0], data + FIRST, size - FIRST);
+
+            _head.store((HEAD + size) & MASK);
 
-            if (next >= BUFFER_SIZE)
+            return size;
+        }
+
+        // get last element without removing it
+        bool peek(T& result)
+        {
+            if (isEmpty())
             {
-                next = 0;
+                return false;
             }
 
-            result = _buffer[next];
+            result = _buffer[(_tail.loadRelaxed() + 1) & MASK];
 
             return true;
         }
@@ -108,27 +145,169 @@ namespace core::util
                 return false;
             }
 
-            size_t next = _tail + 1;
+            const size_t NEXT = (_tail.loadRelaxed() + 1) & MASK;
+
+            result = _buffer[NEXT];
+            _tail.store(NEXT);
+
+            return true;
+        }
+
+        /// Removes up to specified amount of elements from the buffer.
+        /// Data is copied out in at most two contiguous segments (before and after the wrap).
+        /// param [in]: data    Pointer to array in which removed elements will be stored.
+        /// param [in]: size    Maximum amount of elements which can be stored in provided array.
+        /// returns: Amount of removed elements.
+        size_t remove(T* data, size_t size)
+        {
+            const size_t TAIL = _tail.loadRelaxed();
+            const size_t USED = (_head.load() - TAIL) & MASK;
+
+            if (size > USED)
+            {
+                size = USED;
+            }
 
-            if (next >= BUFFER_SIZE)
+            if (!size)
             {
-                next = 0;
+                return 0;
             }
 
-            result = _buffer[next];
-            _tail  = next;
+            const size_t START = (TAIL + 1) & MASK;
+            const size_t FIRST = size < (BUFFER_SIZE - START) ? size : (BUFFER_SIZE - START);
 
-            return true;
+            copy(data, &_buffer[START], FIRST);
+            copy(data + FIRST, &_buffer[0], size - FIRST);
+
+            _tail.store((TAIL + size) & MASK);
+
+            return size;
+        }
+
+        /// Producer side of zero-copy access: returns the largest contiguous free region
+        /// into which data can be written directly (eg. by DMA). Written elements become
+        /// visible to the consumer only once commit() is called.
+        /// param [in]: size    Reference to variable in which the size of the region will be stored.
+        /// returns: Pointer to the start of the free region.
+        T* peekSpan(size_t& size)
+        {
+            const size_t HEAD  = _head.loadRelaxed();
+            const size_t FREE  = capacity() - ((HEAD - _tail.load()) & MASK);
+            const size_t START = (HEAD + 1) & MASK;
+
+            size = FREE < (BUFFER_SIZE - START) ? FREE : (BUFFER_SIZE - START);
+
+            return &_buffer[START];
+        }
+
+        /// Publishes specified amount of elements written into the region returned by peekSpan().
+        void commit(size_t size)
+        {
+            _head.store((_head.loadRelaxed() + size) & MASK);
+        }
+
+        /// Consumer side of zero-copy access: returns the largest contiguous region of stored
+        /// elements which can be read directly (eg. by DMA). Elements are released back to
+        /// the producer only once consume() is called.
+        /// param [in]: size    Reference to variable in which the size of the region will be stored.
+        /// returns: Pointer to the start of the stored region.
+        const T* readSpan(size_t& size)
+        {
+            const size_t TAIL  = _tail.loadRelaxed();
+            const size_t USED  = (_head.load() - TAIL) & MASK;
+            const size_t START = (TAIL + 1) & MASK;
+
+            size = USED < (BUFFER_SIZE - START) ? USED : (BUFFER_SIZE - START);
+
+            return &_buffer[START];
+        }
+
+        /// Releases specified amount of elements read from the region returned by readSpan().
+        void consume(size_t size)
+        {
+            _tail.store((_tail.loadRelaxed() + size) & MASK);
         }
 
         void reset()
         {
-            _head = _tail;
+            _head.store(_tail.load());
         }
 
         private:
-        T               _buffer[maxSize] = {};
-        volatile size_t _head            = 0;
-        volatile size_t _tail            = 0;
+        class Index
+        {
+            public:
+#if defined(CORE_MCU_ARCH_AVR) && !defined(CORE_MCU_STUB)
+            // no native atomics on AVR: index is wider than a single byte, so guard
+            // the accesses against tearing instead
+            size_t load() const
+            {
+                size_t value;
+
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    value = _value;
+                }
+
+                return value;
+            }
+
+            size_t loadRelaxed() const
+            {
+                // only the owner of the index uses this, and the owner is the only writer
+                return _value;
+            }
+
+            void store(size_t value)
+            {
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    _value = value;
+                }
+            }
+
+            private:
+            volatile size_t _value = 0;
+#else
+            size_t load() const
+            {
+                return _value.load(std::memory_order_acquire);
+            }
+
+            size_t loadRelaxed() const
+            {
+                return _value.load(std::memory_order_relaxed);
+            }
+
+            void store(size_t value)
+            {
+                _value.store(value, std::memory_order_release);
+            }
+
+            private:
+            std::atomic<size_t> _value = { 0 };
+#endif
+        };
+
+        static constexpr size_t MASK = BUFFER_SIZE - 1;
+
+        static void copy(T* destination, const T* source, size_t size)
+        {
+            if constexpr (std::is_trivially_copyable_v<T>)
+            {
+                memcpy(destination, source, size * sizeof(T));
+            }
+            else
+            {
+                for (size_t i = 0; i < size; i++)
+                {
+                    destination[i] = source[i];
+                }
+            }
+        }
+
+        T     _buffer[maxSize] = {};
+        Index _head;
+        Index _tail;
     };
 }    // namespace core::util
@@ -22,17 +22,38 @@
 
 #pragma once
 
-#include <cstddef>
-#include <memory>
-#include <vector>
-#include <functional>
+#include <inttypes.h>
+#include <stddef.h>
+#include <array>
+#include "core/util/handler.h"
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+#include "core/mcu.h"
+#endif
+
+// Tasks are owned by the caller and linked into the scheduler (no allocation
+// takes place). Running tasks are kept in binary min-heap ordered by deadline,
+// so that update() only touches the tasks which have expired and the time until
+// the next deadline is known without walking all the tasks.
+// Maximum amount of registered tasks can be overridden by defining
+// CORE_UTIL_SCHEDULER_MAX_TASKS_USER.
+// Define CORE_UTIL_SCHEDULER_STATS to collect per-task statistics: execution time is
+// measured with core::mcu::timing::us(), lateness in the time base of the scheduler.
+
+#ifdef CORE_UTIL_SCHEDULER_MAX_TASKS_USER
+#define CORE_UTIL_SCHEDULER_MAX_TASKS CORE_UTIL_SCHEDULER_MAX_TASKS_USER
+#else
+#define CORE_UTIL_SCHEDULER_MAX_TASKS 16
+#endif
 
 namespace core::util
 {
+    class Scheduler;
+
     class Task
     {
         public:
-        using taskFunc_t = std::function<void()>;
+        using taskFunc_t = Handler<void()>;
 
         enum class taskType_t : uint8_t
         {
@@ -40,53 +61,256 @@ namespace core::util
             RECURRING
         };
 
-        Task(size_t taskID, uint32_t timeout, taskFunc_t&& func)
-            : TASK_ID(taskID)
-            , TIMEOUT(timeout)
-            , _func(std::move(func))
-        {}
+        /// Determines what happens with recurring task which is run later than one whole period
+        /// after its deadline.
+        enum class overrunPolicy_t : uint8_t
+        {
+            SKIP,        ///< Periods which have passed are dropped: task is run once.
+            CATCH_UP,    ///< Task is run once for each period which has passed.
+        };
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+        struct Stats
+        {
+            uint32_t runs            = 0;
+            uint32_t minUs           = UINT32_MAX;    ///< UINT32_MAX until the first run completes.
+            uint32_t maxUs           = 0;
+            uint64_t totalUs         = 0;
+            uint32_t maxLatenessMs   = 0;
+            uint64_t totalLatenessMs = 0;
+
+            /// Periods dropped with SKIP policy, or runs which were late by at least one
+            /// whole period with CATCH_UP policy.
+            uint32_t missedPeriods = 0;
+
+            uint32_t averageUs() const
+            {
+                return runs ? totalUs / runs : 0;
+            }
 
-        Task(size_t taskID, uint32_t timeout, taskFunc_t& func)
-            : TASK_ID(taskID)
-            , TIMEOUT(timeout)
+            uint32_t averageLatenessMs() const
+            {
+                return runs ? totalLatenessMs / runs : 0;
+            }
+        };
+#endif
+
+        Task(uint32_t timeout, taskType_t taskType, taskFunc_t func, overrunPolicy_t overrunPolicy = overrunPolicy_t::SKIP)
+            : _timeout(timeout)
+            , TASK_TYPE(taskType)
+            , OVERRUN_POLICY(overrunPolicy)
             , _func(func)
         {}
 
-        void start()
+        Task(const Task&)            = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task();
+
+        /// (Re)starts the task: it will expire once the timeout elapses.
+        /// Task needs to be registered in the scheduler first. Tasks with timeout
+        /// set to 0 are never started: running task is stopped instead.
+        void start();
+
+        /// Changes the timeout and (re)starts the task.
+        void start(uint32_t timeout)
+        {
+            _timeout = timeout;
+            start();
+        }
+
+        /// Stops the task without running it.
+        void stop();
+
+        bool isRunning() const
+        {
+            return _heapIndex != NOT_RUNNING;
+        }
+
+        /// Sets the ID used to identify the task in the statistics dump.
+        void setId(uint16_t id)
         {
-            _timeRemaining = TIMEOUT;
+            _id = id;
         }
 
-        void stop()
+        uint16_t id() const
         {
-            _timeRemaining = 0;
+            return _id;
         }
 
-        bool isRunning()
+#ifdef CORE_UTIL_SCHEDULER_STATS
+        const Stats& stats() const
         {
-            return _timeRemaining;
+            return _stats;
         }
 
+        void resetStats()
+        {
+            _stats = {};
+        }
+#endif
+
         private:
         friend class Scheduler;
 
-        const size_t   TASK_ID;
-        const uint32_t TIMEOUT;
-        int32_t        _timeRemaining = 0;
-        taskFunc_t     _func;
+        static constexpr size_t NOT_RUNNING = static_cast<size_t>(-1);
+
+        uint32_t              _timeout;
+        const taskType_t      TASK_TYPE;
+        const overrunPolicy_t OVERRUN_POLICY;
+        taskFunc_t            _func;
+        Scheduler*            _scheduler = nullptr;
+        uint32_t              _deadline  = 0;
+        size_t                _heapIndex = NOT_RUNNING;
+        size_t                _index     = 0;    ///< Position among the registered tasks.
+        uint16_t              _id        = 0;
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+        Stats _stats;
+#endif
     };
 
     class Scheduler
     {
         public:
+        static constexpr size_t MAX_TASKS = CORE_UTIL_SCHEDULER_MAX_TASKS;
+
         Scheduler() = default;
 
-        std::shared_ptr<Task> registerTask(uint32_t timeout, Task::taskType_t taskType, Task::taskFunc_t func)
+        Scheduler(const Scheduler&)            = delete;
+        Scheduler& operator=(const Scheduler&) = delete;
+
+        virtual ~Scheduler()
+        {
+            clear();
+        }
+
+        /// Links the task into the scheduler. Task isn't started.
+        /// returns: False if the task is already registered or the maximum amount
+        /// of tasks has been reached, true otherwise.
+        bool registerTask(Task& task)
+        {
+            if ((task._scheduler != nullptr) || (_totalTasks == MAX_TASKS))
+            {
+                return false;
+            }
+
+            task._scheduler       = this;
+            task._index           = _totalTasks;
+            _tasks[_totalTasks++] = &task;
+
+            return true;
+        }
+
+        /// Stops the task and removes it from the scheduler.
+        void unregisterTask(Task& task)
+        {
+            if (task._scheduler != this)
+            {
+                return;
+            }
+
+            remove(task);
+
+            _tasks[task._index]         = _tasks[--_totalTasks];
+            _tasks[task._index]->_index = task._index;
+            task._scheduler             = nullptr;
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+            if (_runningTask == &task)
+            {
+                _runningTask = nullptr;
+            }
+#endif
+        }
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+        static constexpr uint8_t STATS_DUMP_VERSION     = 1;
+        static constexpr size_t  STATS_DUMP_HEADER_SIZE = 7;
+        static constexpr size_t  STATS_DUMP_RECORD_SIZE = 26;
+
+        /// Writes the statistics of all registered tasks in compact binary format. All the
+        /// values are little-endian.
+        /// Header: dump version (1 byte), amount of records (2), scheduler time in ms (4).
+        /// Record: task ID (2), runs (4), minimum, average and maximum execution time in us (4 each),
+        /// average and maximum lateness in ms (2 each, saturated), missed periods (4).
+        /// Minimum execution time is 0 for the tasks which haven't run yet.
+        /// Only the records which fit into the buffer are written.
+        /// returns: Amount of bytes written, 0 if the buffer can't hold even the header.
+        size_t dumpStats(uint8_t* buffer, size_t size) const
+        {
+            if (size < STATS_DUMP_HEADER_SIZE)
+            {
+                return 0;
+            }
+
+            size_t records = (size - STATS_DUMP_HEADER_SIZE) / STATS_DUMP_RECORD_SIZE;
+
+            if (records > _totalTasks)
+            {
+                records = _totalTasks;
+            }
+
+            size_t offset = 0;
+
+            auto put = [&](uint32_t value, size_t bytes)
+            {
+                for (size_t i = 0; i < bytes; i++)
+                {
+                    buffer[offset++] = value >> (8 * i);
+                }
+            };
+
+            auto saturated = [](uint32_t value)
+            {
+                return value > UINT16_MAX ? UINT16_MAX : value;
+            };
+
+            put(STATS_DUMP_VERSION, 1);
+            put(records, 2);
+            put(_now, 4);
+
+            for (size_t i = 0; i < records; i++)
+            {
+                const auto& task  = *_tasks[i];
+                const auto& stats = task._stats;
+
+                put(task._id, 2);
+                put(stats.runs, 4);
+                put(stats.minUs == UINT32_MAX ? 0 : stats.minUs, 4);
+                put(stats.averageUs(), 4);
+                put(stats.maxUs, 4);
+                put(saturated(stats.averageLatenessMs()), 2);
+                put(saturated(stats.maxLatenessMs), 2);
+                put(stats.missedPeriods, 4);
+            }
+
+            return offset;
+        }
+
+        /// Clears the statistics of all registered tasks.
+        void resetStats()
         {
-            auto task = std::make_shared<Task>(_taskCounter++, timeout, std::move(func));
-            _tasks.push_back({ task, taskType });
+            for (size_t i = 0; i < _totalTasks; i++)
+            {
+                _tasks[i]->resetStats();
+            }
+        }
+#endif
 
-            return task;
+        /// Returns the amount of milliseconds until the earliest running task expires.
+        /// returns: False if no task is running, true otherwise.
+        bool nextDeadline(uint32_t& ms) const
+        {
+            if (!_runningTasks)
+            {
+                return false;
+            }
+
+            const int32_t REMAINING = static_cast<int32_t>(_heap[0]->_deadline - _now);
+            ms                      = REMAINING > 0 ? REMAINING : 0;
+
+            return true;
         }
 
         protected:
@@ -97,47 +321,269 @@ namespace core::util
 
         void update(uint32_t elapsedMs)
         {
-            for (size_t i = 0; i < _tasks.size(); i++)
+            _now += elapsedMs;
+
+            while (_runningTasks && expired(*_heap[0]))
             {
-                auto task = _tasks[i].task.lock();
+                Task&          task     = *_heap[0];
+                const uint32_t LATENESS = _now - task._deadline;
+                uint32_t       missed   = 0;
 
-                if (task->_timeRemaining)
+                if (task.TASK_TYPE == Task::taskType_t::RECURRING)
                 {
-                    task->_timeRemaining -= elapsedMs;
+                    // keep the period aligned to the original start
+                    task._deadline += task._timeout;
 
-                    if (task->_timeRemaining <= 0)
+                    if (task.OVERRUN_POLICY == Task::overrunPolicy_t::CATCH_UP)
                     {
-                        if (task->_func != nullptr)
-                        {
-                            task->_func();
-                        }
-
-                        if (_tasks[i].type == Task::taskType_t::ONE_SHOT)
-                        {
-                            task->_timeRemaining = 0;
-                        }
-                        else
-                        {
-                            task->start();
-                        }
+                        // deadline stays in the past until the task catches up:
+                        // it's run again within this update
+                        missed = LATENESS >= task._timeout;
                     }
+                    else if (expired(task))
+                    {
+                        missed = (_now - task._deadline) / task._timeout + 1;
+                        task._deadline += missed * task._timeout;
+                    }
+
+                    siftDown(0);
+                }
+                else
+                {
+                    remove(task);
+                }
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+                auto& stats = task._stats;
+                stats.runs++;
+                stats.totalLatenessMs += LATENESS;
+                stats.missedPeriods += missed;
+
+                if (LATENESS > stats.maxLatenessMs)
+                {
+                    stats.maxLatenessMs = LATENESS;
                 }
+#else
+                (void)missed;
+#endif
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+                _runningTask         = &task;
+                const uint32_t START = core::mcu::timing::us();
+#endif
+
+                // rescheduled before running so that the callback is free to
+                // stop or restart the task
+                if (task._func)
+                {
+                    task._func();
+                }
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+                // task could have been unregistered (and destroyed) by its own callback
+                if (_runningTask != nullptr)
+                {
+                    record(task, core::mcu::timing::us() - START);
+                }
+
+                _runningTask = nullptr;
+#endif
             }
         }
 
         void clear()
         {
-            _tasks = {};
+            for (size_t i = 0; i < _totalTasks; i++)
+            {
+                _tasks[i]->_heapIndex = Task::NOT_RUNNING;
+                _tasks[i]->_scheduler = nullptr;
+            }
+
+            _totalTasks   = 0;
+            _runningTasks = 0;
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+            _runningTask = nullptr;
+#endif
         }
 
         private:
-        struct taskInternal_t
+        friend class Task;
+
+        std::array<Task*, MAX_TASKS> _tasks        = {};    ///< All registered tasks.
+        std::array<Task*, MAX_TASKS> _heap         = {};    ///< Running tasks, earliest deadline first.
+        size_t                       _totalTasks   = 0;
+        size_t                       _runningTasks = 0;
+        uint32_t                     _now          = 0;
+
+#ifdef CORE_UTIL_SCHEDULER_STATS
+        Task* _runningTask = nullptr;    ///< Task whose callback is being run.
+
+        static void record(Task& task, uint32_t us)
         {
-            std::weak_ptr<Task> task;
-            Task::taskType_t    type;
-        };
+            auto& stats = task._stats;
+            stats.totalUs += us;
+
+            if (us < stats.minUs)
+            {
+                stats.minUs = us;
+            }
+
+            if (us > stats.maxUs)
+            {
+                stats.maxUs = us;
+            }
+        }
+#endif
+
+        bool expired(const Task& task) const
+        {
+            return static_cast<int32_t>(task._deadline - _now) <= 0;
+        }
+
+        static bool earlier(const Task* first, const Task* second)
+        {
+            return static_cast<int32_t>(first->_deadline - second->_deadline) < 0;
+        }
+
+        void place(Task* task, size_t index)
+        {
+            _heap[index]     = task;
+            task->_heapIndex = index;
+        }
+
+        void siftUp(size_t index)
+        {
+            Task* task = _heap[index];
+
+            while (index)
+            {
+                const size_t PARENT = (index - 1) / 2;
+
+                if (!earlier(task, _heap[PARENT]))
+                {
+                    break;
+                }
+
+                place(_heap[PARENT], index);
+                index = PARENT;
+            }
+
+            place(task, index);
+        }
+
+        void siftDown(size_t index)
+        {
+            Task* task = _heap[index];
+
+            while (true)
+            {
+                size_t child = index * 2 + 1;
+
+                if (child >= _runningTasks)
+                {
+                    break;
+                }
+
+                if (((child + 1) < _runningTasks) && earlier(_heap[child + 1], _heap[child]))
+                {
+                    child++;
+                }
 
-        std::vector<taskInternal_t> _tasks;
-        size_t                      _taskCounter = 0;
+                if (!earlier(_heap[child], task))
+                {
+                    break;
+                }
+
+                place(_heap[child], index);
+                index = child;
+            }
+
+            place(task, index);
+        }
+
+        /// Moves the task whose deadline has changed to its place in the heap.
+        void resift(size_t index)
+        {
+            if (index && earlier(_heap[index], _heap[(index - 1) / 2]))
+            {
+                siftUp(index);
+            }
+            else
+            {
+                siftDown(index);
+            }
+        }
+
+        void insert(Task& task)
+        {
+            place(&task, _runningTasks++);
+            siftUp(task._heapIndex);
+        }
+
+        void remove(Task& task)
+        {
+            if (!task.isRunning())
+            {
+                return;
+            }
+
+            const size_t INDEX = task._heapIndex;
+            task._heapIndex    = Task::NOT_RUNNING;
+
+            if (INDEX == --_runningTasks)
+            {
+                return;
+            }
+
+            place(_heap[_runningTasks], INDEX);
+            resift(INDEX);
+        }
+
+        void start(Task& task)
+        {
+            const bool RUNNING = task.isRunning();
+            task._deadline     = _now + task._timeout;
+
+            if (RUNNING)
+            {
+                resift(task._heapIndex);
+            }
+            else
+            {
+                insert(task);
+            }
+        }
     };
-}    // namespace core::util
\ No newline at end of file
+
+    inline Task::~Task()
+    {
+        if (_scheduler != nullptr)
+        {
+            _scheduler->unregisterTask(*this);
+        }
+    }
+
+    inline void Task::start()
+    {
+        if (!_timeout)
+        {
+            // running task would otherwise stay in the heap with zero period
+            stop();
+            return;
+        }
+
+        if (_scheduler != nullptr)
+        {
+            _scheduler->start(*this);
+        }
+    }
+
+    inline void Task::stop()
+    {
+        if (_scheduler != nullptr)
+        {
+            _scheduler->remove(*this);
+        }
+    }
+}    // namespace core::util
@@ -22,6 +22,8 @@
 #pragma once
 
 #include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
 
 namespace core::util
 {
@@ -43,9 +45,80 @@ namespace core::util
         {
             public:
             virtual bool write(uint8_t data) = 0;
+
+            /// Writes block of data.
+            /// Default implementation writes byte by byte: sinks which can accept blocks
+            /// directly (UART, USB) should override this.
+            virtual bool write(const uint8_t* data, size_t size)
+            {
+                for (size_t i = 0; i < size; i++)
+                {
+                    if (!write(data[i]))
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+        };
+
+        /// Writer which stores encoded data into caller-supplied buffer.
+        /// Multiple packets can be encoded back to back into the same buffer and sent at once.
+        class BufferWriter : public WriterBase
+        {
+            public:
+            BufferWriter(uint8_t* buffer, size_t capacity)
+                : _buffer(buffer)
+                , _capacity(capacity)
+            {}
+
+            bool write(uint8_t data) override
+            {
+                return write(&data, 1);
+            }
+
+            bool write(const uint8_t* data, size_t size) override
+            {
+                if (size > freeSpace())
+                {
+                    return false;
+                }
+
+                memcpy(&_buffer[_size], data, size);
+                _size += size;
+
+                return true;
+            }
+
+            uint8_t* buffer() const
+            {
+                return _buffer;
+            }
+
+            size_t size() const
+            {
+                return _size;
+            }
+
+            size_t freeSpace() const
+            {
+                return _capacity - _size;
+            }
+
+            void reset()
+            {
+                _size = 0;
+            }
+
+            private:
+            uint8_t*     _buffer = nullptr;
+            const size_t _capacity;
+            size_t       _size = 0;
         };
 
         class PacketReader;
+        class PacketDecoder;
 
         class Packet
         {
@@ -103,6 +176,7 @@ namespace core::util
 
             private:
             friend class PacketReader;
+            friend class PacketDecoder;
 
             uint8_t*     _payload = nullptr;
             const size_t _payloadCapacity;
@@ -209,6 +283,131 @@ namespace core::util
             ReaderBase& _reader;
         };
 
+        /// Decodes SLIP stream delivered in blocks of arbitrary size, without per-byte virtual calls.
+        /// END and ESC bytes are located with memchr and literal runs between them are copied into
+        /// the packet in bulk. Decoding state is kept in the packet, so packet which spans across
+        /// multiple blocks is resumed with the next block.
+        /// Empty frames (leading END bytes used to cancel out line noise) are skipped.
+        class PacketDecoder
+        {
+            public:
+            PacketDecoder() = default;
+
+            /// Decodes provided block until complete packet is assembled or until the block is exhausted.
+            /// Once the packet is complete, its payload needs to be processed before calling this function
+            /// again since the next packet is assembled in the same buffer.
+            /// param [in]: packet      Packet in which decoded payload is stored.
+            /// param [in]: data        Pointer to raw SLIP data.
+            /// param [in]: size        Amount of bytes in provided block.
+            /// param [in]: complete    Reference to variable in which the packet completion state is stored.
+            /// returns: Amount of consumed bytes from provided block.
+            size_t decode(Packet& packet, const uint8_t* data, size_t size, bool& complete)
+            {
+                complete = false;
+
+                if (packet.payload() == nullptr)
+                {
+                    return size;
+                }
+
+                size_t pos = 0;
+
+                while (pos < size)
+                {
+                    auto   frameEnd = static_cast<const uint8_t*>(memchr(data + pos, SLIP::END, size - pos));
+                    size_t limit    = frameEnd != nullptr ? static_cast<size_t>(frameEnd - data) : size;
+
+                    while (pos < limit)
+                    {
+                        if (packet._escapeProcessing)
+                        {
+                            unescape(packet, data[pos++]);
+                            continue;
+                        }
+
+                        auto   esc    = static_cast<const uint8_t*>(memchr(data + pos, SLIP::ESC, limit - pos));
+                        size_t runEnd = esc != nullptr ? static_cast<size_t>(esc - data) : limit;
+
+                        append(packet, data + pos, runEnd - pos);
+                        pos = runEnd;
+
+                        if (esc != nullptr)
+                        {
+                            packet._escapeProcessing = true;
+                            pos++;
+                        }
+                    }
+
+                    if (frameEnd == nullptr)
+                    {
+                        break;
+                    }
+
+                    // skip END byte
+                    pos++;
+                    packet._escapeProcessing = false;
+
+                    if (packet._readCounter)
+                    {
+                        packet._payloadLength = packet._readCounter;
+                        packet._readCounter   = 0;
+                        complete              = true;
+                        break;
+                    }
+                }
+
+                return pos;
+            }
+
+            private:
+            void append(Packet& packet, const uint8_t* data, size_t size)
+            {
+                size_t space = packet._payloadCapacity - packet._readCounter;
+
+                // bytes which don't fit are dropped
+                if (size > space)
+                {
+                    size = space;
+                }
+
+                memcpy(&packet._payload[packet._readCounter], data, size);
+                packet._readCounter += size;
+            }
+
+            void unescape(Packet& packet, uint8_t data)
+            {
+                packet._escapeProcessing = false;
+
+                switch (data)
+                {
+                case SLIP::ESC_END:
+                {
+                    data = SLIP::END;
+                }
+                break;
+
+                case SLIP::ESC_ESC:
+                {
+                    data = SLIP::ESC;
+                }
+                break;
+
+                case SLIP::ESC:
+                {
+                    // two escape bytes in a row should never occur
+                    packet._readCounter = 0;
+                    return;
+                }
+                break;
+
+                default:
+                    break;
+                }
+
+                append(packet, &data, 1);
+            }
+        };
+
         class PacketWriter
         {
             public:
@@ -221,80 +420,84 @@ namespace core::util
                 return _writer.write(SLIP::ESC);
             }
 
+            /// Writes the packet to the underlying writer.
+            /// Payload is split into maximal runs of bytes which don't need escaping, and each run
+            /// is written as a single block.
             bool write(const Packet& packet)
             {
+                static constexpr uint8_t ESCAPED_END[2] = { SLIP::ESC, SLIP::ESC_END };
+                static constexpr uint8_t ESCAPED_ESC[2] = { SLIP::ESC, SLIP::ESC_ESC };
+
                 if (packet.payload() == nullptr)
                 {
                     return false;
                 }
 
-                auto writeByte = [this](uint8_t byte)
+                // start the packet with END byte to cancel out line noise if present
+                if (!_writer.write(SLIP::END))
                 {
-                    switch (byte)
-                    {
-                    case SLIP::END:
-                    {
-                        if (!_writer.write(SLIP::ESC))
-                        {
-                            return false;
-                        }
+                    return false;
+                }
 
-                        if (!_writer.write(SLIP::ESC_END))
-                        {
-                            return false;
-                        }
+                // payload
+                const uint8_t* payload = packet.payload();
+                const size_t   length  = packet.payloadLength();
+                size_t         pos     = 0;
+
+                while (pos < length)
+                {
+                    size_t runEnd = pos;
+
+                    while ((runEnd < length) && (payload[runEnd] != SLIP::END) && (payload[runEnd] != SLIP::ESC))
+                    {
+                        runEnd++;
                     }
-                    break;
 
-                    case SLIP::ESC:
+                    if (runEnd != pos)
                     {
-                        if (!_writer.write(SLIP::ESC))
+                        if (!_writer.write(&payload[pos], runEnd - pos))
                         {
                             return false;
                         }
 
-                        if (!_writer.write(SLIP::ESC_ESC))
-                        {
-                            return false;
-                        }
+                        pos = runEnd;
                     }
-                    break;
 
-                    default:
+                    if (pos < length)
                     {
-                        if (!_writer.write(byte))
+                        if (!_writer.write(payload[pos] == SLIP::END ? ESCAPED_END : ESCAPED_ESC, 2))
                         {
                             return false;
                         }
-                    }
-                    break;
-                    }
 
-                    return true;
-                };
+                        pos++;
+                    }
+                }
 
-                // start the packet with END byte to cancel out line noise if present
+                // end boundary
                 if (!_writer.write(SLIP::END))
                 {
                     return false;
                 }
 
-                // payload
+                return true;
+            }
+
+            /// Returns the amount of bytes the packet occupies once encoded.
+            /// Used to check whether the packet fits into BufferWriter before writing it.
+            static size_t encodedSize(const Packet& packet)
+            {
+                size_t size = packet.payloadLength() + 2;
+
                 for (size_t i = 0; i < packet.payloadLength(); i++)
                 {
-                    if (!writeByte(packet[i]))
+                    if ((packet[i] == SLIP::END) || (packet[i] == SLIP::ESC))
                     {
-                        return false;
+                        size++;
                     }
                 }
 
-                // end boundary
-                if (!_writer.write(SLIP::END))
-                {
-                    return false;
-                }
-
-                return true;
+                return size;
             }
 
             private:
@@ -91,25 +91,6 @@ namespace core::util
         return index;
     }
 
-    inline uint16_t XMODEM(uint16_t crc, uint8_t data)
-    {
-        crc = crc ^ (static_cast<uint16_t>(data) << 8);
-
-        for (int i = 0; i < 8; i++)
-        {
-            if (crc & 0x8000)
-            {
-                crc = (crc << 1) ^ 0x1021;
-            }
-            else
-            {
-                crc <<= 1;
-            }
-        }
-
-        return crc;
-    }
-
     template<typename T>
     constexpr inline bool BIT_READ(T value, size_t bit)
     {
@@ -139,16 +120,18 @@ namespace core::util
 // however, that concept doesn't exist on other platforms
 // in that case, allow compiling the AVR code by re-defining certain functions/macros
 #if defined(CORE_MCU_ARCH_AVR) && !defined(CORE_MCU_STUB)
-#define CORE_UTIL_READ_PROGMEM_ARRAY(string) (PGM_P) pgm_read_word(&(string))
-#define CORE_UTIL_READ_PROGMEM_BYTE(address) pgm_read_byte(&address)
-#define CORE_UTIL_READ_PROGMEM_WORD(address) pgm_read_word(&address)
+#define CORE_UTIL_READ_PROGMEM_ARRAY(string)  (PGM_P) pgm_read_word(&(string))
+#define CORE_UTIL_READ_PROGMEM_BYTE(address)  pgm_read_byte(&address)
+#define CORE_UTIL_READ_PROGMEM_WORD(address)  pgm_read_word(&address)
+#define CORE_UTIL_READ_PROGMEM_DWORD(address) pgm_read_dword(&address)
 #else
 #define PROGMEM
-#define PGM_P                                const char*
-#define strcpy_P                             strcpy
-#define CORE_UTIL_READ_PROGMEM_ARRAY(string) (const char*)((string))
-#define CORE_UTIL_READ_PROGMEM_BYTE(address) address
-#define CORE_UTIL_READ_PROGMEM_WORD(address) address
+#define PGM_P                                 const char*
+#define strcpy_P                              strcpy
+#define CORE_UTIL_READ_PROGMEM_ARRAY(string)  (const char*)((string))
+#define CORE_UTIL_READ_PROGMEM_BYTE(address)  address
+#define CORE_UTIL_READ_PROGMEM_WORD(address)  address
+#define CORE_UTIL_READ_PROGMEM_DWORD(address) address
 #endif
 
 #ifdef CORE_MCU_STUB
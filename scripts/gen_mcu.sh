@@ -99,7 +99,7 @@ if [[ $mcu == "stub" ]]
 then
     # Stub MCU only
     {
-        printf "%s\n" "target_compile_definitions($cmake_mcu_target PUBLIC CORE_MCU_MAX_UART_INTERFACES=0)"
+        printf "%s\n" "target_compile_definitions($cmake_mcu_target PUBLIC CORE_MCU_MAX_UART_INTERFACES=$($yaml_parser "$yaml_file" peripherals.uart))"
         printf "%s\n" "target_compile_definitions($cmake_mcu_target PUBLIC CORE_MCU_MAX_I2C_INTERFACES=0)"
     } >> "$out_cmakelists"
 else
@@ -26,8 +26,7 @@ namespace core::mcu::bootloader
 {
     bool erasePage(size_t index)
     {
-        resetCache();
-        return core::mcu::flash::erasePage(index);
+        return eraseCachedPage(index);
     }
 
     bool fillPage(size_t index, uint32_t addressInPage, uint32_t data)
@@ -19,6 +19,7 @@
     OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <string.h>
 #include "core/arch/common/flash.h"
 #include "core/error_handler.h"
 #include "core/arch/arm/nordic/common/mcu.h"
@@ -28,12 +29,62 @@
 #include "nrf_fstorage.h"
 #include "nrf_fstorage_sd.h"
 
+#ifdef CORE_MCU_FLASH_ASYNC_QUEUE_SIZE_USER
+#define ASYNC_QUEUE_SIZE CORE_MCU_FLASH_ASYNC_QUEUE_SIZE_USER
+#else
+#define ASYNC_QUEUE_SIZE 8
+#endif
+
+namespace
+{
+    void fstorageHandler(nrf_fstorage_evt_t* event);
+
+    class AsyncDriver
+    {
+        public:
+        bool start(const core::mcu::flash::async::Request& request);
+    };
+
+    AsyncDriver                                                  _asyncDriver;
+    core::mcu::flash::async::Queue<ASYNC_QUEUE_SIZE, AsyncDriver> _asyncQueue(_asyncDriver);
+}    // namespace
+
 NRF_FSTORAGE_DEF(nrf_fstorage_t _fstorage) = {
-    .evt_handler = NULL,
+    .evt_handler = fstorageHandler,
     .start_addr  = reinterpret_cast<uint32_t>(__flash_start__),
     .end_addr    = core::mcu::flash::size() - 1,
 };
 
+namespace
+{
+    bool AsyncDriver::start(const core::mcu::flash::async::Request& request)
+    {
+        // requests are tagged with the queue so that the completions of blocking
+        // operations can be told apart
+        if (request.operation == core::mcu::flash::async::operation_t::ERASE)
+        {
+            return nrf_fstorage_erase(&_fstorage,
+                                      core::mcu::flash::pageAddress(request.address),
+                                      1,
+                                      &_asyncQueue) == NRF_SUCCESS;
+        }
+
+        return nrf_fstorage_write(&_fstorage,
+                                  request.address,
+                                  request.data,
+                                  request.size,
+                                  &_asyncQueue) == NRF_SUCCESS;
+    }
+
+    void fstorageHandler(nrf_fstorage_evt_t* event)
+    {
+        if (event->p_param == &_asyncQueue)
+        {
+            _asyncQueue.complete(event->result == NRF_SUCCESS);
+        }
+    }
+}    // namespace
+
 namespace core::mcu::flash
 {
     bool init()
@@ -77,6 +128,53 @@ namespace core::mcu::flash
         return (*(volatile uint32_t*)address) == data;
     }
 
+    bool write(uint32_t address, const uint8_t* data, size_t size)
+    {
+        if ((address % 4) || (size % 4))
+        {
+            return false;
+        }
+
+        if (reinterpret_cast<uintptr_t>(data) % 4)
+        {
+            // SoftDevice requires word-aligned source - fall back to writing word by word
+            for (size_t i = 0; i < size; i += 4)
+            {
+                uint32_t word = 0;
+                memcpy(&word, &data[i], sizeof(word));
+
+                if (!write32(address + i, word))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // the entire block is written with single request: fstorage splits it into
+        // chunks as needed, so the busy-wait happens only once
+        CORE_ERROR_CHECK(nrf_fstorage_write(&_fstorage,
+                                            address,
+                                            data,
+                                            size,
+                                            NULL),
+                         NRF_SUCCESS);
+
+        while (nrf_fstorage_is_busy(&_fstorage))
+        {
+            sd_app_evt_wait();
+        }
+
+        return memcmp(reinterpret_cast<const void*>(address), data, size) == 0;
+    }
+
+    bool flush()
+    {
+        // data is written directly
+        return true;
+    }
+
     bool read8(uint32_t address, uint8_t& data)
     {
         data = (*(volatile uint8_t*)address);
@@ -94,4 +192,61 @@ namespace core::mcu::flash
         data = (*(volatile uint32_t*)address);
         return true;
     }
+
+    bool read(uint32_t address, uint8_t* data, size_t size)
+    {
+        // flash is memory-mapped
+        memcpy(data, reinterpret_cast<const void*>(address), size);
+        return true;
+    }
+
+    namespace async
+    {
+        bool erasePage(size_t index, callback_t callback, void* context)
+        {
+            Request request;
+
+            request.operation = operation_t::ERASE;
+            request.address   = index;
+            request.callback  = callback;
+            request.context   = context;
+
+            return _asyncQueue.push(request);
+        }
+
+        bool write(uint32_t address, const uint8_t* data, size_t size, callback_t callback, void* context)
+        {
+            // no fallback for unaligned source here: the data isn't copied
+            if ((address % 4) || (size % 4) || !size || (reinterpret_cast<uintptr_t>(data) % 4))
+            {
+                return false;
+            }
+
+            Request request;
+
+            request.operation = operation_t::WRITE;
+            request.address   = address;
+            request.data      = data;
+            request.size      = size;
+            request.callback  = callback;
+            request.context   = context;
+
+            return _asyncQueue.push(request);
+        }
+
+        void update()
+        {
+            _asyncQueue.update();
+        }
+
+        size_t pending()
+        {
+            return _asyncQueue.pending();
+        }
+
+        bool isBusy()
+        {
+            return nrf_fstorage_is_busy(&_fstorage);
+        }
+    }    // namespace async
 }    // namespace core::mcu::flash
\ No newline at end of file
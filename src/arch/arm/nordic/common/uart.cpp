@@ -21,8 +21,10 @@
 
 #include <map>
 #include "core/arch/common/uart.h"
+#include "core/arch/common/uart_dma.h"
 #include "core/mcu.h"
 #include "nrfx_uarte.h"
+#include "app_timer.h"
 
 namespace
 {
@@ -101,16 +103,47 @@ namespace
         },
     };
 
-    uint8_t       _nrfTxBuffer[CORE_MCU_MAX_UART_INTERFACES];
-    uint8_t       _nrfRxBuffer[CORE_MCU_MAX_UART_INTERFACES];
-    volatile bool _transmitting[CORE_MCU_MAX_UART_INTERFACES];
-    nrfx_uarte_t  _uartInstance[CORE_MCU_MAX_UART_INTERFACES] = {
+#ifdef CORE_MCU_UART_DMA_RX_BUFFER_SIZE_USER
+    constexpr size_t DMA_RX_BUFFER_SIZE = CORE_MCU_UART_DMA_RX_BUFFER_SIZE_USER;
+#else
+    constexpr size_t DMA_RX_BUFFER_SIZE = 64;
+#endif
+
+    // EasyDMA is limited by the width of MAXCNT register
+    constexpr size_t DMA_MAX_TRANSFER = (1UL << UARTE0_EASYDMA_MAXCNT_SIZE) - 1;
+
+    // in DMA mode, received data which didn't fill up the buffer is passed
+    // on once there was no activity on the line for this long
+    constexpr uint32_t RX_TIMEOUT_MS = 1;
+
+    enum class rxState_t : uint8_t
+    {
+        IDLE,         // waiting for the first byte
+        RECEIVING,    // data is being received, idle timeout is checked
+        STOPPING,     // receiver stopped after idle timeout, waiting for RXTO
+        FLUSHING,     // collecting the data left in receiver FIFO
+    };
+
+    uint8_t                                                _nrfTxBuffer[CORE_MCU_MAX_UART_INTERFACES];
+    uint8_t                                                _nrfRxBuffer[CORE_MCU_MAX_UART_INTERFACES];
+    volatile bool                                          _transmitting[CORE_MCU_MAX_UART_INTERFACES];
+    bool                                                   _dma[CORE_MCU_MAX_UART_INTERFACES];
+    size_t                                                 _dmaTxSize[CORE_MCU_MAX_UART_INTERFACES];
+    volatile rxState_t                                     _dmaRxState[CORE_MCU_MAX_UART_INTERFACES];
+    core::mcu::uart::DmaRxDoubleBuffer<DMA_RX_BUFFER_SIZE> _dmaRxBuffer[CORE_MCU_MAX_UART_INTERFACES];
+    volatile bool                                          _rxTimeoutTimerRunning;
+    bool                                                   _rxTimeoutTimerCreated;
+    nrfx_uarte_t                                           _uartInstance[CORE_MCU_MAX_UART_INTERFACES] = {
         NRFX_UARTE_INSTANCE(0),
         NRFX_UARTE_INSTANCE(1),
     };
 
+    // per-byte handlers are used only when DMA mode isn't enabled
     core::mcu::uart::rxHandler_t _rxHandler[CORE_MCU_MAX_UART_INTERFACES];
     core::mcu::uart::txHandler_t _txHandler[CORE_MCU_MAX_UART_INTERFACES];
+    core::mcu::uart::SpanHandler _spanHandler[CORE_MCU_MAX_UART_INTERFACES];
+
+    APP_TIMER_DEF(_rxTimeoutTimer);
 
     enum class txEvent_t : uint8_t
     {
@@ -121,15 +154,37 @@ namespace
 
     inline void checkTx(uint8_t channel, txEvent_t event)
     {
-        size_t  remainingBytes;
-        uint8_t value;
+        const uint8_t* data = nullptr;
+        size_t         size = 0;
 
-        if (_txHandler[channel](value, remainingBytes))
+        if (_dma[channel])
+        {
+            // send directly from channel buffer - previous block is released here
+            data = _spanHandler[channel].next(_dmaTxSize[channel], size);
+
+            if (size > DMA_MAX_TRANSFER)
+            {
+                size = DMA_MAX_TRANSFER;
+            }
+
+            _dmaTxSize[channel] = size;
+        }
+        else
+        {
+            size_t remainingBytes;
+
+            if (_txHandler[channel](_nrfTxBuffer[channel], remainingBytes))
+            {
+                data = &_nrfTxBuffer[channel];
+                size = 1;
+            }
+        }
+
+        if (size)
         {
-            _nrfTxBuffer[channel] = value;
             nrf_uarte_event_clear(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_ENDTX);
             nrf_uarte_event_clear(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_TXSTOPPED);
-            nrf_uarte_tx_buffer_set(_uartInstance[channel].p_reg, &_nrfTxBuffer[channel], 1);
+            nrf_uarte_tx_buffer_set(_uartInstance[channel].p_reg, data, size);
             _transmitting[channel] = true;
             nrf_uarte_task_trigger(_uartInstance[channel].p_reg, NRF_UARTE_TASK_STARTTX);
         }
@@ -151,11 +206,109 @@ namespace
             }
         }
     }
+
+    void startRxTimeout()
+    {
+        CORE_MCU_ATOMIC_SECTION
+        {
+            if (!_rxTimeoutTimerRunning)
+            {
+                _rxTimeoutTimerRunning = true;
+                app_timer_start(_rxTimeoutTimer, APP_TIMER_TICKS(RX_TIMEOUT_MS), nullptr);
+            }
+        }
+    }
+
+    void dmaRxStart(uint8_t channel)
+    {
+        auto reg = _uartInstance[channel].p_reg;
+
+        // reception continues into the next buffer (set once RXSTARTED occurs) without CPU intervention
+        nrf_uarte_rx_buffer_set(reg, _dmaRxBuffer[channel].active(), DMA_RX_BUFFER_SIZE);
+        nrf_uarte_shorts_enable(reg, NRF_UARTE_SHORT_ENDRX_STARTRX);
+
+        // RXDRDY interrupt is used only to detect the start of incoming data
+        _dmaRxState[channel] = rxState_t::IDLE;
+        nrf_uarte_event_clear(reg, NRF_UARTE_EVENT_RXDRDY);
+        nrf_uarte_int_enable(reg, NRF_UARTE_INT_RXDRDY_MASK);
+
+        nrf_uarte_task_trigger(reg, NRF_UARTE_TASK_STARTRX);
+    }
+
+    void dmaRxEnd(uint8_t channel)
+    {
+        _dmaRxBuffer[channel].complete(nrf_uarte_rx_amount_get(_uartInstance[channel].p_reg),
+                                       [channel](const uint8_t* data, size_t size)
+                                       {
+                                           _spanHandler[channel].received(data, size);
+                                       });
+
+        if (_dmaRxState[channel] == rxState_t::FLUSHING)
+        {
+            // everything left in receiver FIFO has been collected
+            dmaRxStart(channel);
+        }
+    }
+
+    void rxTimeoutHandler(void* context)
+    {
+        for (size_t channel = 0; channel < CORE_MCU_MAX_UART_INTERFACES; channel++)
+        {
+            if (!_dma[channel])
+            {
+                continue;
+            }
+
+            CORE_MCU_ATOMIC_SECTION
+            {
+                if (_dmaRxState[channel] == rxState_t::RECEIVING)
+                {
+                    auto reg = _uartInstance[channel].p_reg;
+
+                    if (nrf_uarte_event_check(reg, NRF_UARTE_EVENT_RXDRDY))
+                    {
+                        nrf_uarte_event_clear(reg, NRF_UARTE_EVENT_RXDRDY);
+                    }
+                    else
+                    {
+                        // line was idle for the entire period: stop the receiver so that
+                        // ENDRX is generated for partially filled buffer
+                        _dmaRxState[channel] = rxState_t::STOPPING;
+                        nrf_uarte_shorts_disable(reg, NRF_UARTE_SHORT_ENDRX_STARTRX);
+                        nrf_uarte_task_trigger(reg, NRF_UARTE_TASK_STOPRX);
+                    }
+                }
+            }
+        }
+
+        CORE_MCU_ATOMIC_SECTION
+        {
+            bool receiving = false;
+
+            for (size_t channel = 0; channel < CORE_MCU_MAX_UART_INTERFACES; channel++)
+            {
+                if (_dmaRxState[channel] == rxState_t::RECEIVING)
+                {
+                    receiving = true;
+                    break;
+                }
+            }
+
+            if (!receiving)
+            {
+                app_timer_stop(_rxTimeoutTimer);
+                _rxTimeoutTimerRunning = false;
+            }
+        }
+    }
 }    // namespace
 
 namespace core::mcu::uart::hw
 {
-    bool init(const Config& config, rxHandler_t&& rxHandler, txHandler_t&& txHandler)
+    bool init(const Config&      config,
+              rxHandler_t&&      rxHandler,
+              txHandler_t&&      txHandler,
+              const SpanHandler& spanHandler)
     {
         // unsupported by NRF52
         if (config.parity == Config::parity_t::ODD)
@@ -196,6 +349,29 @@ namespace core::mcu::uart::hw
                                 CORE_NRF_GPIO_PIN_MAP(config.pins.rx.port,
                                                       config.pins.rx.index));
 
+        _rxHandler[config.channel]   = std::move(rxHandler);
+        _txHandler[config.channel]   = std::move(txHandler);
+        _spanHandler[config.channel] = spanHandler;
+        _dma[config.channel]         = config.dma;
+        _dmaTxSize[config.channel]   = 0;
+
+        if (config.dma)
+        {
+            if (!_rxTimeoutTimerCreated)
+            {
+                if (app_timer_create(&_rxTimeoutTimer, APP_TIMER_MODE_REPEATED, rxTimeoutHandler) != NRF_SUCCESS)
+                {
+                    return false;
+                }
+
+                _rxTimeoutTimerCreated = true;
+            }
+
+            nrf_uarte_int_enable(_uartInstance[config.channel].p_reg,
+                                 NRF_UARTE_INT_RXSTARTED_MASK |
+                                     NRF_UARTE_INT_RXTO_MASK);
+        }
+
         nrf_uarte_int_enable(_uartInstance[config.channel].p_reg,
                              NRF_UARTE_INT_ENDRX_MASK |
                                  NRF_UARTE_INT_ENDTX_MASK |
@@ -205,12 +381,18 @@ namespace core::mcu::uart::hw
         NVIC_ClearPendingIRQ(nrfx_get_irq_number((void*)_uartInstance[config.channel].p_reg));
         NRFX_IRQ_ENABLE(nrfx_get_irq_number((void*)_uartInstance[config.channel].p_reg));
 
-        nrf_uarte_rx_buffer_set(_uartInstance[config.channel].p_reg, &_nrfRxBuffer[config.channel], 1);
         nrf_uarte_enable(_uartInstance[config.channel].p_reg);
-        nrf_uarte_task_trigger(_uartInstance[config.channel].p_reg, NRF_UARTE_TASK_STARTRX);
 
-        _rxHandler[config.channel] = std::move(rxHandler);
-        _txHandler[config.channel] = std::move(txHandler);
+        if (config.dma)
+        {
+            _dmaRxBuffer[config.channel].reset();
+            dmaRxStart(config.channel);
+        }
+        else
+        {
+            nrf_uarte_rx_buffer_set(_uartInstance[config.channel].p_reg, &_nrfRxBuffer[config.channel], 1);
+            nrf_uarte_task_trigger(_uartInstance[config.channel].p_reg, NRF_UARTE_TASK_STARTRX);
+        }
 
         return true;
     }
@@ -222,8 +404,12 @@ namespace core::mcu::uart::hw
                                   NRF_UARTE_INT_ENDTX_MASK |
                                   NRF_UARTE_INT_ERROR_MASK |
                                   NRF_UARTE_INT_RXTO_MASK |
+                                  NRF_UARTE_INT_RXSTARTED_MASK |
+                                  NRF_UARTE_INT_RXDRDY_MASK |
                                   NRF_UARTE_INT_TXSTOPPED_MASK);
 
+        nrf_uarte_shorts_disable(_uartInstance[config.channel].p_reg, NRF_UARTE_SHORT_ENDRX_STARTRX);
+
         NRFX_IRQ_DISABLE(nrfx_get_irq_number((void*)_uartInstance[config.channel].p_reg));
 
         nrf_uarte_disable(_uartInstance[config.channel].p_reg);
@@ -231,6 +417,10 @@ namespace core::mcu::uart::hw
         CORE_MCU_IO_DEINIT(config.pins.tx);
         CORE_MCU_IO_DEINIT(config.pins.rx);
 
+        _dma[config.channel]          = false;
+        _dmaRxState[config.channel]   = rxState_t::IDLE;
+        _transmitting[config.channel] = false;
+
         return true;
     }
 
@@ -242,9 +432,12 @@ namespace core::mcu::uart::hw
         // and data needs to be written to internal NRF buffer.
         // Do this only if current data transfer has completed.
 
-        if (!_transmitting[config.channel])
+        CORE_MCU_ATOMIC_SECTION
         {
-            checkTx(config.channel, txEvent_t::COMPLETE);
+            if (!_transmitting[config.channel])
+            {
+                checkTx(config.channel, txEvent_t::COMPLETE);
+            }
         }
     }
 }    // namespace core::mcu::uart::hw
@@ -261,18 +454,53 @@ void core::mcu::isr::uart(uint8_t channel)
         // receive buffer is filled up
 
         nrf_uarte_event_clear(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_ENDRX);
-        _rxHandler[channel](_nrfRxBuffer[channel]);
-        nrf_uarte_task_trigger(_uartInstance[channel].p_reg, NRF_UARTE_TASK_STARTRX);
+
+        if (_dma[channel])
+        {
+            dmaRxEnd(channel);
+        }
+        else
+        {
+            _rxHandler[channel](_nrfRxBuffer[channel]);
+            nrf_uarte_task_trigger(_uartInstance[channel].p_reg, NRF_UARTE_TASK_STARTRX);
+        }
+    }
+
+    if (_dma[channel])
+    {
+        // new transfer has started: queue the other buffer for the following one
+        if (nrf_uarte_event_check(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_RXSTARTED))
+        {
+            nrf_uarte_event_clear(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_RXSTARTED);
+            nrf_uarte_rx_buffer_set(_uartInstance[channel].p_reg, _dmaRxBuffer[channel].next(), DMA_RX_BUFFER_SIZE);
+        }
+
+        // first byte after idle period: from now on, data is collected by DMA and passed on after idle timeout
+        if (nrf_uarte_int_enable_check(_uartInstance[channel].p_reg, NRF_UARTE_INT_RXDRDY_MASK) &&
+            nrf_uarte_event_check(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_RXDRDY))
+        {
+            nrf_uarte_int_disable(_uartInstance[channel].p_reg, NRF_UARTE_INT_RXDRDY_MASK);
+            nrf_uarte_event_clear(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_RXDRDY);
+            _dmaRxState[channel] = rxState_t::RECEIVING;
+            startRxTimeout();
+        }
     }
 
     // Receiver timeout
     if (nrf_uarte_event_check(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_RXTO))
     {
         nrf_uarte_event_clear(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_RXTO);
+
+        if (_dma[channel])
+        {
+            // receiver is stopped: move whatever is left in its FIFO to the buffer (ENDRX follows)
+            _dmaRxState[channel] = rxState_t::FLUSHING;
+            nrf_uarte_task_trigger(_uartInstance[channel].p_reg, NRF_UARTE_TASK_FLUSHRX);
+        }
     }
 
-    //  tx empty
-    if (nrf_uarte_event_check(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_TXDRDY))
+    //  tx empty - only relevant when sending byte by byte
+    if (!_dma[channel] && nrf_uarte_event_check(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_TXDRDY))
     {
         nrf_uarte_event_clear(_uartInstance[channel].p_reg, NRF_UARTE_EVENT_TXDRDY);
         checkTx(channel, txEvent_t::EMPTY);
@@ -19,26 +19,67 @@
     OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <string.h>
 #include "hardware/flash.h"
 #include "core/arch/common/flash.h"
+#include "core/arch/common/flash_page_cache.h"
 #include "core/arch/arm/rpf/common/atomic.h"
 
 namespace
 {
-    constexpr uint32_t PAGE_SIZE               = 256;
-    constexpr uint32_t SECTOR_SIZE             = 4096;
-    uint8_t            _sectorBuf[SECTOR_SIZE] = {};
-    uint32_t           _lastCachedSector       = 0xFFFFFFFF;
+    // Each write on RP2040 external flash must be done on a 256-byte boundary.
+    // If the addresses in the page aren't writeable, 4k sector in which the page
+    // resides must be erased first.
+    constexpr uint32_t PAGE_SIZE   = 256;
+    constexpr uint32_t SECTOR_SIZE = 4096;
+
+    // pico sdk expects just the offset from start flash address as an address
+    class Driver
+    {
+        public:
+        void read(uint32_t offset, uint8_t* data, size_t size)
+        {
+            memcpy(data, reinterpret_cast<const void*>(core::mcu::flash::startAddress() + offset), size);
+        }
+
+        void erase(uint32_t offset, size_t size)
+        {
+            CORE_MCU_ATOMIC_SECTION
+            {
+                flash_range_erase(offset, size);
+            }
+        }
+
+        void program(uint32_t offset, const uint8_t* data, size_t size)
+        {
+            CORE_MCU_ATOMIC_SECTION
+            {
+                flash_range_program(offset, data, size);
+            }
+        }
+    };
+
+    Driver                                                      _driver;
+    core::mcu::flash::PageCache<PAGE_SIZE, SECTOR_SIZE, Driver> _cache(_driver);
+
+    bool isRangeValid(uint32_t address, size_t size)
+    {
+        return size && core::mcu::flash::isInRange(address) && core::mcu::flash::isInRange(address + size - 1);
+    }
 }    // namespace
 
 namespace core::mcu::flash
 {
     bool erasePage(size_t index)
     {
+        const uint32_t OFFSET = index * pageSize(index);
+
+        _cache.invalidate(OFFSET, pageSize(index));
+
         // pico sdk expects just the offset from start flash address as an address for flash_range_erase
         CORE_MCU_ATOMIC_SECTION
         {
-            flash_range_erase(index * pageSize(index), pageSize(index));
+            flash_range_erase(OFFSET, pageSize(index));
         }
 
         return true;
@@ -46,99 +87,69 @@ namespace core::mcu::flash
 
     bool write32(uint32_t address, uint32_t data)
     {
-        if (!isInRange(address))
+        return write(address, reinterpret_cast<const uint8_t*>(&data), sizeof(data));
+    }
+
+    bool write(uint32_t address, const uint8_t* data, size_t size)
+    {
+        if (!isRangeValid(address, size))
         {
             return false;
         }
 
-        // Each write on RP2040 external flash must be done on a 256-byte boundary.
-        // If the addresses in the page aren't writeable, 4k sector in which the page
-        // resides must be erased first.
-
-        const size_t   SECTOR               = (address - core::mcu::flash::startAddress()) / SECTOR_SIZE;
-        const size_t   PAGE                 = (address - core::mcu::flash::startAddress()) / PAGE_SIZE;
-        const size_t   INDEX_IN_SECTOR      = (address - core::mcu::flash::startAddress()) % SECTOR_SIZE;
-        const size_t   PAGE_WITHIN_SECTOR   = INDEX_IN_SECTOR / PAGE_SIZE;
-        const uint32_t SECTOR_START_ADDRESS = SECTOR * SECTOR_SIZE;
-        const uint32_t PAGE_START_ADDRESS   = PAGE * PAGE_SIZE;
-
-        bool erase = false;
-
-        // cache the entire sector first
-        if (_lastCachedSector != SECTOR)
-        {
-            for (size_t i = 0; i < SECTOR_SIZE; i++)
-            {
-                read8(core::mcu::flash::startAddress() + SECTOR_START_ADDRESS + i, _sectorBuf[i]);
-            }
+        // data is only cached here: each modified page gets programmed once flush is called
+        // or once the data in another sector is written
+        _cache.write(address - core::mcu::flash::startAddress(), data, size);
+        return true;
+    }
 
-            _lastCachedSector = SECTOR;
-        }
+    bool flush()
+    {
+        _cache.flush();
+        return true;
+    }
 
-        // Erasing a sector takes a long time (~45ms) - do it only if needed.
-        // Verify if the current addresses are writeable (value 0xFF).
-        for (size_t i = 0; i < 4; i++)
+    bool read8(uint32_t address, uint8_t& data)
+    {
+        if (!isRangeValid(address, sizeof(data)))
         {
-            if (_sectorBuf[INDEX_IN_SECTOR + i] == (data >> (8 * i) & static_cast<uint32_t>(0xFF)))
-            {
-                // same value - skip
-                continue;
-            }
-
-            if (_sectorBuf[INDEX_IN_SECTOR + i] != 0xFF)
-            {
-                erase = true;
-                break;
-            }
+            return false;
         }
 
-        _sectorBuf[INDEX_IN_SECTOR + 0] = data >> 0 & static_cast<uint32_t>(0xFF);
-        _sectorBuf[INDEX_IN_SECTOR + 1] = data >> 8 & static_cast<uint32_t>(0xFF);
-        _sectorBuf[INDEX_IN_SECTOR + 2] = data >> 16 & static_cast<uint32_t>(0xFF);
-        _sectorBuf[INDEX_IN_SECTOR + 3] = data >> 24 & static_cast<uint32_t>(0xFF);
-
-        // pico sdk expects just the offset from start flash address as an address
+        _cache.read(address - core::mcu::flash::startAddress(), &data, sizeof(data));
+        return true;
+    }
 
-        if (erase)
-        {
-            CORE_MCU_ATOMIC_SECTION
-            {
-                // wipe the entire sector first and write back updated values
-                flash_range_erase(SECTOR_START_ADDRESS, SECTOR_SIZE);
-                flash_range_program(SECTOR_START_ADDRESS, (const uint8_t*)&_sectorBuf, SECTOR_SIZE);
-            }
-        }
-        else
+    bool read16(uint32_t address, uint16_t& data)
+    {
+        if (!isRangeValid(address, sizeof(data)))
         {
-            CORE_MCU_ATOMIC_SECTION
-            {
-                // just update the page
-                flash_range_program(PAGE_START_ADDRESS, (const uint8_t*)&_sectorBuf[PAGE_WITHIN_SECTOR * PAGE_SIZE], PAGE_SIZE);
-            }
+            return false;
         }
 
+        _cache.read(address - core::mcu::flash::startAddress(), reinterpret_cast<uint8_t*>(&data), sizeof(data));
         return true;
     }
 
-    bool read8(uint32_t address, uint8_t& data)
+    bool read32(uint32_t address, uint32_t& data)
     {
-        if (!isInRange(address))
+        if (!isRangeValid(address, sizeof(data)))
         {
             return false;
         }
 
-        data = (*(volatile uint8_t*)address);
+        _cache.read(address - core::mcu::flash::startAddress(), reinterpret_cast<uint8_t*>(&data), sizeof(data));
         return true;
     }
 
-    bool read32(uint32_t address, uint32_t& data)
+    bool read(uint32_t address, uint8_t* data, size_t size)
     {
-        if (!isInRange(address))
+        if (!isRangeValid(address, size))
         {
             return false;
         }
 
-        data = (*(volatile uint32_t*)address);
+        _cache.read(address - core::mcu::flash::startAddress(), data, size);
         return true;
     }
-}    // namespace core::mcu::flash
\ No newline at end of file
+}    // namespace core::mcu::flash
@@ -62,7 +62,8 @@ namespace core::mcu::timers
     {
         for (size_t i = 0; i < _timer.size(); i++)
         {
-            if (!_timer[i].allocated)
+            // alarm could be claimed elsewhere, see core::mcu::timing
+            if (!_timer[i].allocated && !hardware_alarm_is_claimed(i))
             {
                 _timer[i].allocated = true;
                 _timer[i].handler   = handler;
@@ -22,10 +22,14 @@
 #include "hardware/uart.h"
 #include "hardware/irq.h"
 #include "core/arch/common/uart.h"
+#include "core/arch/common/uart_fifo.h"
 #include "core/mcu.h"
 
 namespace
 {
+    // depth of both RX and TX hardware FIFO
+    constexpr size_t FIFO_SIZE = 32;
+
     volatile bool _txEnabled[CORE_MCU_MAX_UART_INTERFACES];
 
     constexpr uint8_t UART_IRQ[CORE_MCU_MAX_UART_INTERFACES] = {
@@ -33,8 +37,7 @@ namespace
         UART1_IRQ
     };
 
-    core::mcu::uart::rxHandler_t _rxHandler[CORE_MCU_MAX_UART_INTERFACES];
-    core::mcu::uart::txHandler_t _txHandler[CORE_MCU_MAX_UART_INTERFACES];
+    core::mcu::uart::SpanHandler _spanHandler[CORE_MCU_MAX_UART_INTERFACES];
 
     // Match RX/TX pin indexes with UART interface:
     // RP2040 uses semi-flexible pin mapping for UART -
@@ -78,11 +81,45 @@ namespace
         nullptr,
         nullptr,
     };
+
+    class Fifo
+    {
+        public:
+        Fifo(uart_inst_t* instance)
+            : _instance(instance)
+        {}
+
+        bool readable()
+        {
+            return uart_is_readable(_instance);
+        }
+
+        uint8_t read()
+        {
+            return static_cast<uint8_t>(uart_get_hw(_instance)->dr);
+        }
+
+        bool writable()
+        {
+            return uart_is_writable(_instance);
+        }
+
+        void write(uint8_t data)
+        {
+            uart_get_hw(_instance)->dr = data;
+        }
+
+        private:
+        uart_inst_t* _instance;
+    };
 }    // namespace
 
 namespace core::mcu::uart::hw
 {
-    bool init(const Config& config, rxHandler_t&& rxHandler, txHandler_t&& txHandler)
+    bool init(const Config&      config,
+              rxHandler_t&&      rxHandler,
+              txHandler_t&&      txHandler,
+              const SpanHandler& spanHandler)
     {
         auto instance = uartInstance(config.pins.rx.index, config.pins.tx.index);
 
@@ -100,12 +137,19 @@ namespace core::mcu::uart::hw
 
         uart_set_hw_flow(_uartInstanceMatched[config.channel], false, false);
         uart_set_format(_uartInstanceMatched[config.channel], 8, static_cast<int>(config.stopBits), static_cast<uart_parity_t>(config.parity));
-        uart_set_fifo_enabled(_uartInstanceMatched[config.channel], false);
-        irq_set_enabled(UART_IRQ[config.channel], true);
+        uart_set_fifo_enabled(_uartInstanceMatched[config.channel], true);
+
+        _spanHandler[config.channel] = spanHandler;
+
+        // RX interrupt fires once RX FIFO is half full, or once at least one byte
+        // is waiting and nothing else has been received for 32 bit periods (RX timeout).
+        // TX interrupt fires once TX FIFO drops to 1/8 of its size.
         uart_set_irq_enables(_uartInstanceMatched[config.channel], true, false);
+        hw_write_masked(&uart_get_hw(_uartInstanceMatched[config.channel])->ifls,
+                        (2 << UART_UARTIFLS_RXIFLSEL_LSB) | (0 << UART_UARTIFLS_TXIFLSEL_LSB),
+                        UART_UARTIFLS_RXIFLSEL_BITS | UART_UARTIFLS_TXIFLSEL_BITS);
 
-        _rxHandler[config.channel] = std::move(rxHandler);
-        _txHandler[config.channel] = std::move(txHandler);
+        irq_set_enabled(UART_IRQ[config.channel], true);
 
         return true;
     }
@@ -117,36 +161,41 @@ namespace core::mcu::uart::hw
 
     void startTx(const Config& config)
     {
-        if (!_txEnabled[config.channel])
+        CORE_MCU_ATOMIC_SECTION
         {
-            _txEnabled[config.channel] = true;
-            uart_set_irq_enables(_uartInstanceMatched[config.channel], true, true);
-            irq_set_pending(UART_IRQ[config.channel]);
+            if (!_txEnabled[config.channel])
+            {
+                _txEnabled[config.channel] = true;
+
+                // modify the mask directly: uart_set_irq_enables would also reset FIFO levels
+                hw_set_bits(&uart_get_hw(_uartInstanceMatched[config.channel])->imsc, UART_UARTIMSC_TXIM_BITS);
+                irq_set_pending(UART_IRQ[config.channel]);
+            }
         }
     }
 }    // namespace core::mcu::uart::hw
 
 void core::mcu::isr::uart(uint8_t channel)
 {
-    while (uart_is_readable(_uartInstanceMatched[channel]))
-    {
-        _rxHandler[channel](static_cast<uint8_t>(uart_get_hw(_uartInstanceMatched[channel])->dr));
-    }
+    Fifo fifo(_uartInstanceMatched[channel]);
 
-    if (uart_is_writable(_uartInstanceMatched[channel]))
-    {
-        size_t  remainingBytes;
-        uint8_t value;
+    core::mcu::uart::drainRxFifo<FIFO_SIZE>(fifo,
+                                            [channel](const uint8_t* data, size_t size)
+                                            {
+                                                _spanHandler[channel].received(data, size);
+                                            });
 
-        if (_txHandler[channel](value, remainingBytes))
-        {
-            uart_putc_raw(_uartInstanceMatched[channel], value);
-        }
-        else
+    if (_txEnabled[channel])
+    {
+        if (!core::mcu::uart::fillTxFifo(fifo,
+                                         [channel](size_t sentBytes, size_t& size)
+                                         {
+                                             return _spanHandler[channel].next(sentBytes, size);
+                                         }))
         {
             // there is no "tx complete" event on rp2040 - if there's nothing more to send, disable tx interrupt
             _txEnabled[channel] = false;
-            uart_set_irq_enables(_uartInstanceMatched[channel], true, false);
+            hw_clear_bits(&uart_get_hw(_uartInstanceMatched[channel])->imsc, UART_UARTIMSC_TXIM_BITS);
         }
     }
-}
\ No newline at end of file
+}
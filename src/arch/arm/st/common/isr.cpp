@@ -20,6 +20,7 @@
 */
 
 #include "core/arch/arm/st/common/hal.h"
+#include "core/arch/common/timing.h"
 
 // STM32 common ISRs
 
@@ -68,8 +69,22 @@ extern "C" void PendSV_Handler(void)
 {
 }
 
+#ifdef CORE_MCU_TIMING_TICKLESS
+// SysTick isn't used in tickless mode: HAL time base is derived from core::mcu::timing instead.
+// Until core::mcu::timing::init is called, time doesn't advance, so HAL timeouts don't expire.
+extern "C" HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+    return HAL_OK;
+}
+
+extern "C" uint32_t HAL_GetTick(void)
+{
+    return core::mcu::timing::ms();
+}
+#else
 // This function handles System tick timer.
 extern "C" void SysTick_Handler(void)
 {
     HAL_IncTick();
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
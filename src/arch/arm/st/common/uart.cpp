@@ -20,19 +20,349 @@
 */
 
 #include "core/arch/common/uart.h"
+#include "core/arch/common/uart_dma.h"
+#include "core/arch/common/uart_fifo.h"
 #include "core/mcu.h"
 
 namespace
 {
-    UART_HandleTypeDef           _uartHandler[CORE_MCU_MAX_UART_INTERFACES];
-    volatile bool                _transmitting[CORE_MCU_MAX_UART_INTERFACES];
-    core::mcu::uart::rxHandler_t _rxHandler[CORE_MCU_MAX_UART_INTERFACES];
-    core::mcu::uart::txHandler_t _txHandler[CORE_MCU_MAX_UART_INTERFACES];
+    // DMA is opt-in: once enabled, interrupt handlers of the DMA streams mapped to the
+    // available UART interfaces are defined here, so the application can't use those
+    // streams for other peripherals.
+#ifdef CORE_MCU_UART_DMA
+    constexpr bool DMA_ENABLED = true;
+#else
+    constexpr bool DMA_ENABLED = false;
+#endif
+
+#ifdef CORE_MCU_UART_DMA_RX_BUFFER_SIZE_USER
+    constexpr size_t DMA_RX_BUFFER_SIZE = CORE_MCU_UART_DMA_RX_BUFFER_SIZE_USER;
+#else
+    constexpr size_t DMA_RX_BUFFER_SIZE = 64;
+#endif
+
+    constexpr uint8_t  DMA_NO_CHANNEL       = 0xFF;
+    constexpr uint32_t DMA_MAX_TRANSFER     = 0xFFFF;
+    constexpr uint32_t DMA_FLAG_SHIFT[4]    = { 0, 6, 16, 22 };
+    constexpr uint32_t DMA_STREAM_FLAGS     = 0x3D;
+    constexpr uint32_t DMA_STREAM_FLAG_TCIF = 0x20;
+
+    struct dmaStream_t
+    {
+        uint32_t  base;
+        uint32_t  channel;
+        IRQn_Type irqn;
+    };
+
+    struct dmaRoute_t
+    {
+        uint32_t    uart;
+        dmaStream_t rx;
+        dmaStream_t tx;
+    };
+
+    // fixed DMA request mapping for each UART interface (RM0090, DMA1/DMA2 request mapping tables)
+    constexpr dmaRoute_t DMA_ROUTE[] = {
+        {
+            USART1_BASE,
+            { DMA2_Stream2_BASE, 4, DMA2_Stream2_IRQn },
+            { DMA2_Stream7_BASE, 4, DMA2_Stream7_IRQn },
+        },
+        {
+            USART2_BASE,
+            { DMA1_Stream5_BASE, 4, DMA1_Stream5_IRQn },
+            { DMA1_Stream6_BASE, 4, DMA1_Stream6_IRQn },
+        },
+#ifdef USART3
+        {
+            USART3_BASE,
+            { DMA1_Stream1_BASE, 4, DMA1_Stream1_IRQn },
+            { DMA1_Stream3_BASE, 4, DMA1_Stream3_IRQn },
+        },
+#endif
+#ifdef UART4
+        {
+            UART4_BASE,
+            { DMA1_Stream2_BASE, 4, DMA1_Stream2_IRQn },
+            { DMA1_Stream4_BASE, 4, DMA1_Stream4_IRQn },
+        },
+#endif
+#ifdef UART5
+        {
+            UART5_BASE,
+            { DMA1_Stream0_BASE, 4, DMA1_Stream0_IRQn },
+            { DMA1_Stream7_BASE, 4, DMA1_Stream7_IRQn },
+        },
+#endif
+        {
+            USART6_BASE,
+            { DMA2_Stream1_BASE, 5, DMA2_Stream1_IRQn },
+            { DMA2_Stream6_BASE, 5, DMA2_Stream6_IRQn },
+        },
+    };
+
+    struct dmaStreamOwner_t
+    {
+        uint8_t channel = DMA_NO_CHANNEL;
+        bool    rx      = false;
+    };
+
+    UART_HandleTypeDef                               _uartHandler[CORE_MCU_MAX_UART_INTERFACES];
+    volatile bool                                    _transmitting[CORE_MCU_MAX_UART_INTERFACES];
+    core::mcu::uart::SpanHandler                     _spanHandler[CORE_MCU_MAX_UART_INTERFACES];
+    core::mcu::uart::TxSpanCursor                    _txCursor[CORE_MCU_MAX_UART_INTERFACES];
+    const dmaRoute_t*                                _dmaRoute[CORE_MCU_MAX_UART_INTERFACES];
+    size_t                                           _dmaTxSize[CORE_MCU_MAX_UART_INTERFACES];
+    core::mcu::uart::DmaRxBuffer<DMA_RX_BUFFER_SIZE> _dmaRxBuffer[CORE_MCU_MAX_UART_INTERFACES];
+    dmaStreamOwner_t                                 _dmaStreamOwner[2][8];
+
+    inline DMA_Stream_TypeDef* dmaStream(uint32_t base)
+    {
+        return reinterpret_cast<DMA_Stream_TypeDef*>(base);
+    }
+
+    inline DMA_TypeDef* dmaController(uint32_t base)
+    {
+        return base >= DMA2_BASE ? DMA2 : DMA1;
+    }
+
+    inline uint8_t dmaStreamIndex(uint32_t base)
+    {
+        // stream registers start at offset 0x10 and are 0x18 bytes apart
+        return (base - reinterpret_cast<uint32_t>(dmaController(base)) - 0x10) / 0x18;
+    }
+
+    inline uint32_t dmaFlags(uint32_t base)
+    {
+        auto    controller = dmaController(base);
+        uint8_t index      = dmaStreamIndex(base);
+        auto    reg        = index < 4 ? controller->LISR : controller->HISR;
+
+        return (reg >> DMA_FLAG_SHIFT[index % 4]) & DMA_STREAM_FLAGS;
+    }
+
+    inline void dmaClearFlags(uint32_t base)
+    {
+        auto    controller = dmaController(base);
+        uint8_t index      = dmaStreamIndex(base);
+
+        if (index < 4)
+        {
+            controller->LIFCR = DMA_STREAM_FLAGS << DMA_FLAG_SHIFT[index % 4];
+        }
+        else
+        {
+            controller->HIFCR = DMA_STREAM_FLAGS << DMA_FLAG_SHIFT[index % 4];
+        }
+    }
+
+    void dmaStreamStop(uint32_t base)
+    {
+        auto stream = dmaStream(base);
+
+        stream->CR &= ~DMA_SxCR_EN;
+
+        while (stream->CR & DMA_SxCR_EN)
+        {
+            ;
+        }
+
+        dmaClearFlags(base);
+    }
+
+    void dmaStreamInit(uint8_t channel, const dmaStream_t& descriptor, bool rx)
+    {
+        auto stream = dmaStream(descriptor.base);
+
+        dmaStreamStop(descriptor.base);
+
+        stream->PAR = reinterpret_cast<uint32_t>(&_uartHandler[channel].Instance->DR);
+        stream->FCR = 0;    // direct mode
+        stream->CR  = (descriptor.channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC | DMA_SxCR_PL_1 | DMA_SxCR_TCIE;
+
+        if (rx)
+        {
+            stream->M0AR = reinterpret_cast<uint32_t>(_dmaRxBuffer[channel].data());
+            stream->NDTR = DMA_RX_BUFFER_SIZE;
+            stream->CR |= DMA_SxCR_CIRC | DMA_SxCR_HTIE;
+        }
+        else
+        {
+            stream->CR |= DMA_SxCR_DIR_0;    // memory to peripheral
+        }
+
+        auto& owner   = _dmaStreamOwner[descriptor.base >= DMA2_BASE][dmaStreamIndex(descriptor.base)];
+        owner.channel = channel;
+        owner.rx      = rx;
+
+        // same priority as UART interrupt so that the two never preempt each other
+        HAL_NVIC_SetPriority(descriptor.irqn, 0, 0);
+        HAL_NVIC_EnableIRQ(descriptor.irqn);
+    }
+
+    void dmaStreamDeInit(const dmaStream_t& descriptor)
+    {
+        HAL_NVIC_DisableIRQ(descriptor.irqn);
+        dmaStreamStop(descriptor.base);
+        _dmaStreamOwner[descriptor.base >= DMA2_BASE][dmaStreamIndex(descriptor.base)] = {};
+    }
+
+    bool dmaInit(const core::mcu::uart::Config& config)
+    {
+        using namespace core::mcu::uart;
+
+        const auto INTERFACE = reinterpret_cast<uint32_t>(_uartHandler[config.channel].Instance);
+
+        for (size_t i = 0; i < sizeof(DMA_ROUTE) / sizeof(DMA_ROUTE[0]); i++)
+        {
+            if (DMA_ROUTE[i].uart == INTERFACE)
+            {
+                _dmaRoute[config.channel] = &DMA_ROUTE[i];
+                break;
+            }
+        }
+
+        if (_dmaRoute[config.channel] == nullptr)
+        {
+            return false;
+        }
+
+        __HAL_RCC_DMA1_CLK_ENABLE();
+        __HAL_RCC_DMA2_CLK_ENABLE();
+
+        if ((config.type == Config::type_t::RX_TX) || (config.type == Config::type_t::RX))
+        {
+            _dmaRxBuffer[config.channel].reset();
+            dmaStreamInit(config.channel, _dmaRoute[config.channel]->rx, true);
+            dmaStream(_dmaRoute[config.channel]->rx.base)->CR |= DMA_SxCR_EN;
+            SET_BIT(_uartHandler[config.channel].Instance->CR3, USART_CR3_DMAR);
+
+            // idle line is used to pass on the data which didn't fill half of the buffer
+            __HAL_UART_CLEAR_IDLEFLAG(&_uartHandler[config.channel]);
+            __HAL_UART_ENABLE_IT(&_uartHandler[config.channel], UART_IT_IDLE);
+        }
+
+        if ((config.type == Config::type_t::RX_TX) || (config.type == Config::type_t::TX))
+        {
+            dmaStreamInit(config.channel, _dmaRoute[config.channel]->tx, false);
+            SET_BIT(_uartHandler[config.channel].Instance->CR3, USART_CR3_DMAT);
+        }
+
+        return true;
+    }
+
+    void dmaDeInit(uint8_t channel)
+    {
+        if (_dmaRoute[channel] == nullptr)
+        {
+            return;
+        }
+
+        CLEAR_BIT(_uartHandler[channel].Instance->CR3, USART_CR3_DMAR | USART_CR3_DMAT);
+        dmaStreamDeInit(_dmaRoute[channel]->rx);
+        dmaStreamDeInit(_dmaRoute[channel]->tx);
+        _dmaRoute[channel] = nullptr;
+    }
+
+    void dmaRxFlush(uint8_t channel)
+    {
+        _dmaRxBuffer[channel].update(dmaStream(_dmaRoute[channel]->rx.base)->NDTR,
+                                     [channel](const uint8_t* data, size_t size)
+                                     {
+                                         _spanHandler[channel].received(data, size);
+                                     });
+    }
+
+    void dmaTxNext(uint8_t channel, size_t sentBytes)
+    {
+        size_t size = 0;
+        auto   data = _spanHandler[channel].next(sentBytes, size);
+
+        if (size > DMA_MAX_TRANSFER)
+        {
+            size = DMA_MAX_TRANSFER;
+        }
+
+        _dmaTxSize[channel] = size;
+
+        if (!size)
+        {
+            _transmitting[channel] = false;
+            return;
+        }
+
+        _transmitting[channel] = true;
+
+        auto base   = _dmaRoute[channel]->tx.base;
+        auto stream = dmaStream(base);
+
+        dmaClearFlags(base);
+        stream->M0AR = reinterpret_cast<uint32_t>(data);
+        stream->NDTR = size;
+        stream->CR |= DMA_SxCR_EN;
+    }
+
+    void dmaIsr(uint8_t controller, uint8_t index, uint32_t base)
+    {
+        const auto OWNER = _dmaStreamOwner[controller][index];
+
+        if (OWNER.channel == DMA_NO_CHANNEL)
+        {
+            return;
+        }
+
+        const auto FLAGS = dmaFlags(base);
+        dmaClearFlags(base);
+
+        if (OWNER.rx)
+        {
+            // half transfer or transfer complete
+            dmaRxFlush(OWNER.channel);
+        }
+        else if (FLAGS & DMA_STREAM_FLAG_TCIF)
+        {
+            dmaTxNext(OWNER.channel, _dmaTxSize[OWNER.channel]);
+        }
+    }
 }    // namespace
 
+#define DMA_STREAM_IRQ_HANDLER(controller, index)                              \
+    extern "C" void DMA##controller##_Stream##index##_IRQHandler(void)         \
+    {                                                                          \
+        dmaIsr(controller - 1, index, DMA##controller##_Stream##index##_BASE); \
+    }
+
+// only the streams listed in DMA_ROUTE
+#ifdef CORE_MCU_UART_DMA
+// USART1
+DMA_STREAM_IRQ_HANDLER(2, 2)
+DMA_STREAM_IRQ_HANDLER(2, 7)
+// USART2
+DMA_STREAM_IRQ_HANDLER(1, 5)
+DMA_STREAM_IRQ_HANDLER(1, 6)
+#ifdef USART3
+DMA_STREAM_IRQ_HANDLER(1, 1)
+DMA_STREAM_IRQ_HANDLER(1, 3)
+#endif
+#ifdef UART4
+DMA_STREAM_IRQ_HANDLER(1, 2)
+DMA_STREAM_IRQ_HANDLER(1, 4)
+#endif
+#ifdef UART5
+DMA_STREAM_IRQ_HANDLER(1, 0)
+DMA_STREAM_IRQ_HANDLER(1, 7)
+#endif
+// USART6
+DMA_STREAM_IRQ_HANDLER(2, 1)
+DMA_STREAM_IRQ_HANDLER(2, 6)
+#endif
+
 namespace core::mcu::uart::hw
 {
-    bool init(const Config& config, rxHandler_t&& rxHandler, txHandler_t&& txHandler)
+    bool init(const Config&      config,
+              rxHandler_t&&      rxHandler,
+              txHandler_t&&      txHandler,
+              const SpanHandler& spanHandler)
     {
         _uartHandler[config.channel].Instance        = static_cast<USART_TypeDef*>(core::mcu::peripherals::uartDescriptor(config.channel)->interface());
         _uartHandler[config.channel].Init.BaudRate   = config.baudRate;
@@ -73,20 +403,31 @@ namespace core::mcu::uart::hw
             return false;
         }
 
-        if ((config.type == Config::type_t::RX_TX) || (config.type == Config::type_t::RX))
+        // per-byte handlers aren't used: single-byte transfers are fed from blocks through TX cursor
+        _spanHandler[config.channel] = spanHandler;
+        _txCursor[config.channel].reset();
+
+        if (DMA_ENABLED && config.dma)
+        {
+            if (!dmaInit(config))
+            {
+                HAL_UART_DeInit(&_uartHandler[config.channel]);
+                return false;
+            }
+        }
+        else if ((config.type == Config::type_t::RX_TX) || (config.type == Config::type_t::RX))
         {
             // enable rx interrupt
             __HAL_UART_ENABLE_IT(&_uartHandler[config.channel], UART_IT_RXNE);
         }
 
-        _rxHandler[config.channel] = std::move(rxHandler);
-        _txHandler[config.channel] = std::move(txHandler);
-
         return true;
     }
 
     bool deInit(const Config& config)
     {
+        dmaDeInit(config.channel);
+
         if (HAL_UART_DeInit(&_uartHandler[config.channel]) == HAL_OK)
         {
             _transmitting[config.channel] = false;
@@ -98,6 +439,19 @@ namespace core::mcu::uart::hw
 
     void startTx(const Config& config)
     {
+        if (_dmaRoute[config.channel] != nullptr)
+        {
+            CORE_MCU_ATOMIC_SECTION
+            {
+                if (!_transmitting[config.channel])
+                {
+                    dmaTxNext(config.channel, 0);
+                }
+            }
+
+            return;
+        }
+
         if (!_transmitting[config.channel])
         {
             _transmitting[config.channel] = true;
@@ -108,6 +462,18 @@ namespace core::mcu::uart::hw
 
 void core::mcu::isr::uart(uint8_t channel)
 {
+    if (_dmaRoute[channel] != nullptr)
+    {
+        // with DMA, only idle line detection is routed through UART interrupt
+        if (__HAL_UART_GET_FLAG(&_uartHandler[channel], UART_FLAG_IDLE))
+        {
+            __HAL_UART_CLEAR_IDLEFLAG(&_uartHandler[channel]);
+            dmaRxFlush(channel);
+        }
+
+        return;
+    }
+
     uint32_t isrflags = _uartHandler[channel].Instance->SR;
     uint32_t cr1its   = _uartHandler[channel].Instance->CR1;
     uint8_t  data     = _uartHandler[channel].Instance->DR;
@@ -120,14 +486,20 @@ void core::mcu::isr::uart(uint8_t channel)
 
     if (receiving)
     {
-        _rxHandler[channel](data);
+        _spanHandler[channel].received(&data, 1);
     }
     else if (txEmpty || txComplete)
     {
         size_t  remainingBytes;
         uint8_t value;
 
-        if (_txHandler[channel](value, remainingBytes))
+        if (_txCursor[channel].next(
+                [channel](size_t sentBytes, size_t& size)
+                {
+                    return _spanHandler[channel].next(sentBytes, size);
+                },
+                value,
+                remainingBytes))
         {
             _uartHandler[channel].Instance->DR = value;
 
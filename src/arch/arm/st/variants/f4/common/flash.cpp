@@ -19,6 +19,7 @@
     OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <string.h>
 #include "core/error_handler.h"
 #include "core/mcu.h"
 
@@ -68,6 +69,40 @@ namespace core::mcu::flash
         return (halStatus == HAL_OK);
     }
 
+    _RAM bool write(uint32_t address, const uint8_t* data, size_t size)
+    {
+        if ((address % 4) || (size % 4))
+        {
+            return false;
+        }
+
+        // Unlock the flash only once for the entire block.
+        // Word is the widest program unit available with 2.7-3.6V supply (x64 parallelism requires external VPP).
+        HAL_StatusTypeDef halStatus = HAL_FLASH_Unlock();
+
+        if (halStatus == HAL_OK)
+        {
+            __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+
+            for (size_t i = 0; (i < size) && (halStatus == HAL_OK); i += 4)
+            {
+                uint32_t word = 0;
+                memcpy(&word, &data[i], sizeof(word));
+
+                halStatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + i, word);
+            }
+        }
+
+        HAL_FLASH_Lock();
+        return (halStatus == HAL_OK);
+    }
+
+    bool flush()
+    {
+        // data is written directly
+        return true;
+    }
+
     bool read8(uint32_t address, uint8_t& data)
     {
         data = (*(volatile uint8_t*)address);
@@ -85,4 +120,11 @@ namespace core::mcu::flash
         data = (*(volatile uint32_t*)address);
         return true;
     }
+
+    bool read(uint32_t address, uint8_t* data, size_t size)
+    {
+        // flash is memory-mapped
+        memcpy(data, reinterpret_cast<const void*>(address), size);
+        return true;
+    }
 }    // namespace core::mcu::flash
\ No newline at end of file
@@ -24,25 +24,92 @@
 #include "core/arch/avr/common/atomic.h"
 #include "core/arch/common/flash.h"
 
-namespace core::mcu::bootloader
+namespace
 {
-    bool erasePage(size_t index)
+    // In differential mode, page erase is deferred until commit: words are collected in SPM
+    // buffer regardless, so the page can still be erased and written if any word differs.
+    bool     _differential;
+    size_t   _skippedPages;
+    bool     _deferred;
+    bool     _unchanged;
+    uint32_t _filledStart;
+    uint32_t _filledEnd;
+
+    bool isErased(uint32_t start, uint32_t end)
+    {
+        for (uint32_t address = start; address < end; address += sizeof(uint32_t))
+        {
+            uint32_t data = 0;
+            core::mcu::flash::read32(address, data);
+
+            if (data != 0xFFFFFFFF)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void erase(size_t index)
     {
         CORE_MCU_ATOMIC_SECTION
         {
             boot_page_erase(index * core::mcu::flash::pageSize(index));
             boot_spm_busy_wait();
         }
+    }
+}    // namespace
+
+namespace core::mcu::bootloader
+{
+    bool erasePage(size_t index)
+    {
+        if (_differential)
+        {
+            _deferred    = true;
+            _unchanged   = true;
+            _filledStart = 0xFFFFFFFF;
+            _filledEnd   = 0;
+
+            return true;
+        }
 
+        erase(index);
         return true;
     }
 
     bool fillPage(size_t index, uint32_t addressInPage, uint32_t data)
     {
+        const uint32_t ADDRESS = core::mcu::flash::pageAddress(index) + addressInPage;
+
+        if (_deferred && _unchanged)
+        {
+            uint32_t current = 0;
+            core::mcu::flash::read32(ADDRESS, current);
+
+            if (current != data)
+            {
+                _unchanged = false;
+            }
+            else
+            {
+                if (ADDRESS < _filledStart)
+                {
+                    _filledStart = ADDRESS;
+                }
+
+                if ((ADDRESS + sizeof(uint32_t)) > _filledEnd)
+                {
+                    _filledEnd = ADDRESS + sizeof(uint32_t);
+                }
+            }
+        }
+
         CORE_MCU_ATOMIC_SECTION
         {
-            boot_page_fill_safe(core::mcu::flash::pageAddress(index) + addressInPage, data & static_cast<uint16_t>(0xFFFF));
-            boot_page_fill_safe(core::mcu::flash::pageAddress(index) + addressInPage + 2, data >> 16);
+            boot_page_fill_safe(ADDRESS, data & static_cast<uint16_t>(0xFFFF));
+            boot_page_fill_safe(ADDRESS + 2, data >> 16);
         }
 
         return true;
@@ -50,6 +117,33 @@ namespace core::mcu::bootloader
 
     bool commitPage(size_t index)
     {
+        if (_deferred)
+        {
+            _deferred = false;
+
+            const uint32_t PAGE_START = core::mcu::flash::pageAddress(index);
+            const uint32_t PAGE_END   = PAGE_START + core::mcu::flash::pageSize(index);
+
+            // words which weren't filled end up erased once the page is written
+            if (_unchanged &&
+                ((_filledStart == 0xFFFFFFFF) ? isErased(PAGE_START, PAGE_END)
+                                              : (isErased(PAGE_START, _filledStart) && isErased(_filledEnd, PAGE_END))))
+            {
+                // page isn't written, so SPM buffer isn't cleared automatically:
+                // temporary buffer can't be overwritten, only erased (which RWW enable does)
+                CORE_MCU_ATOMIC_SECTION
+                {
+                    boot_spm_busy_wait();
+                    boot_rww_enable();
+                }
+
+                _skippedPages++;
+                return true;
+            }
+
+            erase(index);
+        }
+
         CORE_MCU_ATOMIC_SECTION
         {
             // write the filled flash page to memory
@@ -62,4 +156,15 @@ namespace core::mcu::bootloader
 
         return true;
     }
-}    // namespace core::mcu::bootloader
\ No newline at end of file
+
+    void setDifferentialMode(bool state)
+    {
+        _differential = state;
+        _skippedPages = 0;
+    }
+
+    size_t skippedPages()
+    {
+        return _skippedPages;
+    }
+}    // namespace core::mcu::bootloader
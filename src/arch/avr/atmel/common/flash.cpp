@@ -41,6 +41,16 @@ namespace core::mcu::flash
         data = pgm_read_dword_far(address);
 #else
         data = pgm_read_dword(address);
+#endif
+        return true;
+    }
+
+    bool read(uint32_t address, uint8_t* data, size_t size)
+    {
+#ifdef pgm_read_byte_far
+        memcpy_PF(data, address, size);
+#else
+        memcpy_P(data, reinterpret_cast<const void*>(address), size);
 #endif
         return true;
     }
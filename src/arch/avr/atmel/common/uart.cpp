@@ -20,13 +20,14 @@
 */
 
 #include "core/arch/common/uart.h"
+#include "core/arch/common/uart_fifo.h"
 #include "core/mcu.h"
 
 namespace
 {
-    volatile bool                _transmitting[CORE_MCU_MAX_UART_INTERFACES];
-    core::mcu::uart::rxHandler_t _rxHandler[CORE_MCU_MAX_UART_INTERFACES];
-    core::mcu::uart::txHandler_t _txHandler[CORE_MCU_MAX_UART_INTERFACES];
+    volatile bool                 _transmitting[CORE_MCU_MAX_UART_INTERFACES];
+    core::mcu::uart::SpanHandler  _spanHandler[CORE_MCU_MAX_UART_INTERFACES];
+    core::mcu::uart::TxSpanCursor _txCursor[CORE_MCU_MAX_UART_INTERFACES];
 }    // namespace
 
 using namespace core::mcu::uart;
@@ -43,19 +44,25 @@ using namespace core::mcu::uart;
 #define _UDRIE_GEN(x) UDRIE_##x
 #define UDRIE(x)      _UDRIE_GEN(x)
 
-#define UDRE_ISR(channel)                             \
-    do                                                \
-    {                                                 \
-        uint8_t data;                                 \
-        size_t  dummy;                                \
-        if (_txHandler[channel](data, dummy))         \
-        {                                             \
-            UDR(channel) = data;                      \
-        }                                             \
-        else                                          \
-        {                                             \
-            UCSRB(channel) &= ~(1 << UDRIE(channel)); \
-        }                                             \
+#define UDRE_ISR(channel)                                               \
+    do                                                                  \
+    {                                                                   \
+        uint8_t data;                                                   \
+        size_t  dummy;                                                  \
+        if (_txCursor[channel].next(                                    \
+                [](size_t sentBytes, size_t& size)                      \
+                {                                                       \
+                    return _spanHandler[channel].next(sentBytes, size); \
+                },                                                      \
+                data,                                                   \
+                dummy))                                                 \
+        {                                                               \
+            UDR(channel) = data;                                        \
+        }                                                               \
+        else                                                            \
+        {                                                               \
+            UCSRB(channel) &= ~(1 << UDRIE(channel));                   \
+        }                                                               \
     } while (0)
 
 #define TXC_ISR(channel)                \
@@ -66,7 +73,10 @@ using namespace core::mcu::uart;
 
 namespace core::mcu::uart::hw
 {
-    bool init(const Config& config, rxHandler_t&& rxHandler, txHandler_t&& txHandler)
+    bool init(const Config&      config,
+              rxHandler_t&&      rxHandler,
+              txHandler_t&&      txHandler,
+              const SpanHandler& spanHandler)
     {
         int32_t baudCount = ((F_CPU / 8) + (config.baudRate / 2)) / config.baudRate;
 
@@ -194,8 +204,10 @@ namespace core::mcu::uart::hw
             break;
         }
 
-        _rxHandler[config.channel] = std::move(rxHandler);
-        _txHandler[config.channel] = std::move(txHandler);
+        // per-byte handlers aren't used: block handlers are dispatched without std::function
+        // overhead and TX cursor retrieves data only once per contiguous block
+        _spanHandler[config.channel] = spanHandler;
+        _txCursor[config.channel].reset();
 
         return true;
     }
@@ -267,14 +279,14 @@ namespace core::mcu::uart::hw
 ISR(USART_RX_vect_0)
 {
     uint8_t data = UDR_0;
-    _rxHandler[0](data);
+    _spanHandler[0].received(&data, 1);
 };
 
 #ifdef UDR_1
 ISR(USART_RX_vect_1)
 {
     uint8_t data = UDR_1;
-    _rxHandler[1](data);
+    _spanHandler[1].received(&data, 1);
 };
 #endif
 
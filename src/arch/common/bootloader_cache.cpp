@@ -19,7 +19,6 @@
     OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-#ifndef CORE_MCU_STUB
 
 #include "core/arch/common/bootloader_cache.h"
 #include "core/arch/common/bootloader.h"
@@ -33,44 +32,235 @@ namespace
     constexpr size_t PAGE_BUFFER_SIZE_WORDS = 1024;
 #endif
 
-    uint32_t _pageBuffer[PAGE_BUFFER_SIZE_WORDS];
-    uint32_t _pageBufferCounter;
-    uint32_t _commitStartAddress;
+#ifdef CORE_MCU_BTLDR_PROGRAM_CHUNK_WORDS_USER
+    constexpr size_t PROGRAM_CHUNK_WORDS = CORE_MCU_BTLDR_PROGRAM_CHUNK_WORDS_USER;
+#else
+    constexpr size_t PROGRAM_CHUNK_WORDS = 16;
+#endif
+
+    // Cache is split into two buffers of equal size: one receives incoming words while the other
+    // one is written to flash in small chunks, so that neither filling nor programming has to wait
+    // for the entire buffer. Total RAM usage is the same as with single buffer.
+    constexpr size_t   BUFFER_SIZE_WORDS = PAGE_BUFFER_SIZE_WORDS / 2;
+    constexpr uint32_t NO_ADDRESS        = 0xFFFFFFFF;
+
+    static_assert(BUFFER_SIZE_WORDS > 0, "Bootloader cache needs to hold at least two words");
+
+    struct buffer_t
+    {
+        uint32_t data[BUFFER_SIZE_WORDS];
+        size_t   count;
+        size_t   programmed;
+        uint32_t address;
+    };
+
+    buffer_t _buffer[2];
+    size_t   _fillBuffer;
+
+    // In differential mode, page erase is deferred for as long as the incoming words match
+    // the flash contents. Once the first different word arrives, the matching words are read
+    // back from flash into the cache before the page is erased, which is possible only if
+    // the entire page fits into the cache.
+    bool     _differential;
+    size_t   _skippedPages;
+    bool     _deferred;
+    size_t   _deferredIndex;
+    uint32_t _deferredStart;
+    size_t   _deferredWords;
+
+    void resetBuffer(buffer_t& buffer)
+    {
+        buffer.count      = 0;
+        buffer.programmed = 0;
+        buffer.address    = NO_ADDRESS;
+    }
+
+    void program(buffer_t& buffer, size_t maxWords)
+    {
+        size_t words = buffer.count - buffer.programmed;
+
+        if (words > maxWords)
+        {
+            words = maxWords;
+        }
+
+        if (!words)
+        {
+            return;
+        }
+
+        core::mcu::flash::write(buffer.address + (buffer.programmed * sizeof(uint32_t)),
+                                reinterpret_cast<const uint8_t*>(&buffer.data[buffer.programmed]),
+                                words * sizeof(uint32_t));
+
+        buffer.programmed += words;
+    }
+
+    void store(uint32_t address, uint32_t data)
+    {
+        auto& fill = _buffer[_fillBuffer];
+
+        if (fill.address == NO_ADDRESS)
+        {
+            fill.address = address;
+        }
+
+        fill.data[fill.count++] = data;
+    }
+
+    void swapIfFull()
+    {
+        auto& pending = _buffer[!_fillBuffer];
+
+        if (_buffer[_fillBuffer].count >= BUFFER_SIZE_WORDS)
+        {
+            // pending buffer is normally done by now - finish it only if the chunks are too small
+            program(pending, BUFFER_SIZE_WORDS);
+            resetBuffer(pending);
+            _fillBuffer = !_fillBuffer;
+        }
+    }
+
+    bool isErased(uint32_t start, uint32_t end)
+    {
+        for (uint32_t address = start; address < end; address += sizeof(uint32_t))
+        {
+            uint32_t data = 0;
+            core::mcu::flash::read32(address, data);
+
+            if (data != 0xFFFFFFFF)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// Checks whether the deferred page can be left as is: all the received words match
+    /// and the rest of the page is erased, same as it would be after erase.
+    bool isDeferredPageUnchanged()
+    {
+        const uint32_t PAGE_START = core::mcu::flash::pageAddress(_deferredIndex);
+        const uint32_t PAGE_END   = PAGE_START + core::mcu::flash::pageSize(_deferredIndex);
+
+        if (_deferredStart == NO_ADDRESS)
+        {
+            return isErased(PAGE_START, PAGE_END);
+        }
+
+        return isErased(PAGE_START, _deferredStart) &&
+               isErased(_deferredStart + (_deferredWords * sizeof(uint32_t)), PAGE_END);
+    }
+
+    /// Performs deferred erase once the page turns out to be different.
+    void eraseDeferredPage()
+    {
+        _deferred = false;
+
+        for (size_t i = 0; i < _deferredWords; i++)
+        {
+            const uint32_t ADDRESS = _deferredStart + (i * sizeof(uint32_t));
+            uint32_t       data    = 0;
+
+            core::mcu::flash::read32(ADDRESS, data);
+            store(ADDRESS, data);
+
+            // nothing is pending yet, so this just switches to the other buffer
+            swapIfFull();
+        }
+
+        core::mcu::flash::erasePage(_deferredIndex);
+    }
 }    // namespace
 
 namespace core::mcu::bootloader
 {
     void resetCache()
     {
-        _pageBufferCounter  = 0;
-        _commitStartAddress = 0xFFFFFFFF;
+        resetBuffer(_buffer[0]);
+        resetBuffer(_buffer[1]);
+        _fillBuffer = 0;
+        _deferred   = false;
     }
 
-    void fillCache(size_t index, uint32_t addressInPage, uint32_t data)
+    bool eraseCachedPage(size_t index)
     {
-        if (_commitStartAddress == 0xFFFFFFFF)
+        resetCache();
+
+        if (_differential && (core::mcu::flash::pageSize(index) <= (BUFFER_SIZE_WORDS * 2 * sizeof(uint32_t))))
         {
-            _commitStartAddress = addressInPage;
+            _deferred      = true;
+            _deferredIndex = index;
+            _deferredStart = NO_ADDRESS;
+            _deferredWords = 0;
+
+            return true;
         }
 
-        _pageBuffer[_pageBufferCounter++] = data;
+        return core::mcu::flash::erasePage(index);
+    }
+
+    void fillCache(size_t index, uint32_t addressInPage, uint32_t data)
+    {
+        const uint32_t ADDRESS = core::mcu::flash::pageAddress(index) + addressInPage;
 
-        if (_pageBufferCounter >= PAGE_BUFFER_SIZE_WORDS)
+        if (_deferred)
         {
-            flushCache(index);
+            uint32_t current = 0;
+            core::mcu::flash::read32(ADDRESS, current);
+
+            if (_deferredStart == NO_ADDRESS)
+            {
+                _deferredStart = ADDRESS;
+            }
+
+            if (current == data)
+            {
+                // already in flash
+                _deferredWords++;
+                return;
+            }
+
+            eraseDeferredPage();
         }
+
+        store(ADDRESS, data);
+
+        // write out a part of previously filled buffer on each new word
+        program(_buffer[!_fillBuffer], PROGRAM_CHUNK_WORDS);
+        swapIfFull();
     }
 
     void flushCache(size_t index)
     {
-        for (size_t i = 0; i < _pageBufferCounter; i++)
+        if (_deferred)
         {
-            core::mcu::flash::write32(core::mcu::flash::pageAddress(index) + _commitStartAddress + (i * 4),
-                                      _pageBuffer[i]);
+            if (isDeferredPageUnchanged())
+            {
+                _skippedPages++;
+                resetCache();
+                return;
+            }
+
+            eraseDeferredPage();
         }
 
+        program(_buffer[!_fillBuffer], BUFFER_SIZE_WORDS);
+        program(_buffer[_fillBuffer], BUFFER_SIZE_WORDS);
+        core::mcu::flash::flush();
+
         resetCache();
     }
-}    // namespace core::mcu::bootloader
 
-#endif
\ No newline at end of file
+    void setDifferentialMode(bool state)
+    {
+        _differential = state;
+        _skippedPages = 0;
+    }
+
+    size_t skippedPages()
+    {
+        return _skippedPages;
+    }
+}    // namespace core::mcu::bootloader
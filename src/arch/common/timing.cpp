@@ -21,29 +21,135 @@
 
 #include "core/mcu.h"
 
+#if defined(CORE_MCU_TIMING_TICKLESS) && defined(CORE_MCU_ARCH_AVR)
+#error "Tickless timing requires free-running counter which isn't available on AVR"
+#endif
+
 namespace
 {
+    constexpr uint64_t gcd(uint64_t a, uint64_t b)
+    {
+        return b ? gcd(b, a % b) : a;
+    }
+
+    /// Converts ticks to the provided unit. Conversion factor is reduced so that the
+    /// common tick rates need only multiplication, division by constant or shift.
+    template<uint64_t unitsPerSecond>
+    uint64_t ticksTo(uint64_t ticks)
+    {
+        constexpr uint64_t DIVISOR    = gcd(unitsPerSecond, core::mcu::timing::TICKS_PER_SECOND);
+        constexpr uint64_t MULTIPLIER = unitsPerSecond / DIVISOR;
+        constexpr uint64_t TICKS      = core::mcu::timing::TICKS_PER_SECOND / DIVISOR;
+
+        return ticks * MULTIPLIER / TICKS;
+    }
+
+    uint64_t      idleTicks;
+    volatile bool wakeupRequested;
+
+#ifdef CORE_MCU_ARCH_AVR
+    constexpr uint32_t PERIOD_US    = 1000;
+    constexpr uint32_t TICKS_PER_MS = core::mcu::timing::TICKS_PER_SECOND / 1000;
+    volatile uint32_t  mcuMs;
+    size_t             timerIndex;
+#else
+    // Free-running counter is extended to 64 bits by counting its wraparounds.
+    // In default mode, counter is observed in millisecond interrupt which is frequent
+    // enough not to miss any wraparound. In tickless mode, there is no periodic interrupt:
+    // only the counter overflow interrupt is used.
+    // Sequence number is incremented on each update so that the readers can detect being
+    // interrupted and retry instead of locking. Updates themselves are done with interrupts
+    // disabled: counter interrupt can have lower priority than the readers, and the reader
+    // interrupting the update half-way would observe the wraparound twice or not at all.
+    constexpr uint32_t COUNTER_BITS = core::mcu::timing::hw::COUNTER_BITS;
+    constexpr uint64_t COUNTER_MASK = (COUNTER_BITS == 64) ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << (COUNTER_BITS % 64)) - 1;
+    volatile uint32_t  counterWraps;
+    volatile uint32_t  counterSequence;
+
+#ifndef CORE_MCU_TIMING_TICKLESS
     constexpr uint32_t PERIOD_US = 1000;
     volatile uint32_t  mcuMs;
+    volatile uint32_t  counterLast;
+
+    void observeCounter()
+    {
+        if constexpr (COUNTER_BITS < 64)
+        {
+            CORE_MCU_ATOMIC_SECTION
+            {
+                const uint32_t COUNTER = core::mcu::timing::hw::counter();
+
+                if (COUNTER < counterLast)
+                {
+                    counterWraps = counterWraps + 1;
+                }
+
+                counterLast     = COUNTER;
+                counterSequence = counterSequence + 1;
+            }
+        }
+    }
+#endif
+#endif
 }    // namespace
 
+#ifdef CORE_MCU_TIMING_COUNTER_ISR
+extern "C" void CORE_MCU_TIMING_COUNTER_ISR()
+{
+    // wakeup event only needs to wake the core from idle()
+    core::mcu::timing::hw::clearWakeup();
+
+#ifdef CORE_MCU_TIMING_TICKLESS
+    CORE_MCU_ATOMIC_SECTION
+    {
+        if (core::mcu::timing::hw::isOverflowPending())
+        {
+            core::mcu::timing::hw::clearOverflow();
+            counterWraps    = counterWraps + 1;
+            counterSequence = counterSequence + 1;
+        }
+    }
+#endif
+}
+#endif
+
 namespace core::mcu::timing
 {
     void init()
     {
+#ifdef CORE_MCU_ARCH_AVR
+        core::mcu::timers::allocate(timerIndex, []()
+                                    {
+                                        mcuMs = mcuMs + 1;
+                                    });
+
+        core::mcu::timers::setPeriod(timerIndex, PERIOD_US);
+        core::mcu::timers::start(timerIndex);
+#else
+        hw::initCounter();
+
+#ifdef CORE_MCU_TIMING_TICKLESS
+        hw::enableOverflowInterrupt();
+#else
         size_t timerIndex = 0;
 
         core::mcu::timers::allocate(timerIndex, []()
                                     {
-                                        mcuMs++;
+                                        mcuMs = mcuMs + 1;
+                                        observeCounter();
                                     });
 
         core::mcu::timers::setPeriod(timerIndex, PERIOD_US);
         core::mcu::timers::start(timerIndex);
+#endif
+
+        hw::enableInterrupt();
+#endif
     }
 
     uint32_t ms()
     {
+#ifdef CORE_MCU_ARCH_AVR
         uint32_t temp;
 
         CORE_MCU_ATOMIC_SECTION
@@ -52,5 +158,99 @@ namespace core::mcu::timing
         }
 
         return temp;
+#elif defined(CORE_MCU_TIMING_TICKLESS)
+        return ticksTo<1000>(ticks());
+#else
+        // aligned 32-bit reads are atomic
+        return mcuMs;
+#endif
+    }
+
+    uint64_t ticks()
+    {
+#ifdef CORE_MCU_ARCH_AVR
+        // 32-bit millisecond counter can't be read atomically on 8-bit MCU
+        uint32_t ms;
+        uint16_t counter;
+
+        CORE_MCU_ATOMIC_SECTION
+        {
+            ms      = mcuMs;
+            counter = hw::counter(timerIndex);
+
+            // counter has restarted after the interrupts were disabled: account for the period
+            // which hasn't been counted yet, unless the counter was read before the restart
+            if (hw::isPeriodPending(timerIndex) && (counter < (TICKS_PER_MS / 2)))
+            {
+                ms++;
+            }
+        }
+
+        return (static_cast<uint64_t>(ms) * TICKS_PER_MS) + counter;
+#else
+        if constexpr (COUNTER_BITS == 64)
+        {
+            return hw::counter();
+        }
+        else
+        {
+            uint32_t sequence;
+            uint32_t wraps;
+            uint32_t counter;
+            bool     wrapped;
+
+            do
+            {
+                sequence = counterSequence;
+                wraps    = counterWraps;
+                counter  = hw::counter();
+
+#ifdef CORE_MCU_TIMING_TICKLESS
+                // overflow interrupt is pending: account for it unless the counter was read before the overflow
+                wrapped = hw::isOverflowPending() && (counter < (COUNTER_MASK / 2));
+#else
+                // wrapped since the last observation
+                wrapped = counter < counterLast;
+#endif
+            } while (sequence != counterSequence);
+
+            if (wrapped)
+            {
+                wraps++;
+            }
+
+            return (static_cast<uint64_t>(wraps) << (COUNTER_BITS % 64)) | (counter & COUNTER_MASK);
+        }
+#endif
+    }
+
+    uint32_t us()
+    {
+        return ticksTo<1000000>(ticks());
+    }
+
+    uint64_t idleUs()
+    {
+        return ticksTo<1000000>(idleTicks);
+    }
+}    // namespace core::mcu::timing
+
+namespace core::mcu
+{
+    void idle(uint32_t maxUs)
+    {
+        const uint64_t START = timing::ticks();
+
+        timing::hw::sleep(maxUs, wakeupRequested);
+
+        // cleared only after waking: the request made after the caller has checked
+        // for pending work, but before sleeping, prevents the sleep
+        wakeupRequested = false;
+        idleTicks += timing::ticks() - START;
+    }
+
+    void wake()
+    {
+        wakeupRequested = true;
     }
-}    // namespace core::mcu::timing
\ No newline at end of file
+}    // namespace core::mcu
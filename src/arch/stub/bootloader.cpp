@@ -0,0 +1,43 @@
+/*
+    Copyright 2017-2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "core/arch/common/bootloader_cache.h"
+#include "core/arch/common/flash.h"
+
+namespace core::mcu::bootloader
+{
+    bool erasePage(size_t index)
+    {
+        return eraseCachedPage(index);
+    }
+
+    bool fillPage(size_t index, uint32_t addressInPage, uint32_t data)
+    {
+        fillCache(index, addressInPage, data);
+        return true;
+    }
+
+    bool commitPage(size_t index)
+    {
+        flushCache(index);
+        return true;
+    }
+}    // namespace core::mcu::bootloader
\ No newline at end of file
@@ -0,0 +1,321 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <string.h>
+#include "core/mcu.h"
+#include "core/arch/common/flash_page_cache.h"
+
+namespace
+{
+    // Behaves like NOR flash: erase sets all the bits while programming can only clear them.
+    class Driver
+    {
+        public:
+        Driver()
+        {
+            reset();
+        }
+
+        void read(uint32_t offset, uint8_t* data, size_t size)
+        {
+            memcpy(data, &_memory[offset], size);
+        }
+
+        void erase(uint32_t offset, size_t size)
+        {
+            memset(&_memory[offset], 0xFF, size);
+            _stats.erases++;
+            _stats.busyTime += core::mcu::flash::STUB_ERASE_TIME_US * ((size + core::mcu::flash::STUB_SECTOR_SIZE - 1) / core::mcu::flash::STUB_SECTOR_SIZE);
+        }
+
+        void program(uint32_t offset, const uint8_t* data, size_t size)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                _memory[offset + i] &= data[i];
+            }
+
+            _stats.programs++;
+            _stats.programmedBytes += size;
+            _stats.busyTime += core::mcu::flash::STUB_PROGRAM_TIME_US * ((size + core::mcu::flash::STUB_PROGRAM_PAGE_SIZE - 1) / core::mcu::flash::STUB_PROGRAM_PAGE_SIZE);
+        }
+
+        void reset()
+        {
+            memset(_memory, 0xFF, sizeof(_memory));
+            _stats = {};
+        }
+
+        core::mcu::flash::stats_t& stats()
+        {
+            return _stats;
+        }
+
+        private:
+        uint8_t                   _memory[core::mcu::flash::STUB_SECTOR_SIZE * core::mcu::flash::STUB_SECTORS];
+        core::mcu::flash::stats_t _stats;
+    };
+
+    using cache_t = core::mcu::flash::PageCache<core::mcu::flash::STUB_PROGRAM_PAGE_SIZE,
+                                                core::mcu::flash::STUB_SECTOR_SIZE,
+                                                Driver>;
+
+    Driver  _driver;
+    cache_t _cache(_driver);
+
+    bool isRangeValid(uint32_t address, size_t size)
+    {
+        return size && core::mcu::flash::isInRange(address) && core::mcu::flash::isInRange(address + size - 1);
+    }
+
+    // Operations are performed once their estimated duration has elapsed in simulated time.
+    class AsyncDriver
+    {
+        public:
+        bool start(const core::mcu::flash::async::Request& request)
+        {
+            _request = request;
+            _startMs = core::mcu::timing::ms();
+            _busy    = true;
+
+            return true;
+        }
+
+        /// Checks whether the operation in progress has finished.
+        /// returns: True if the operation has finished, false otherwise.
+        bool update(bool& success)
+        {
+            if (!_busy || ((core::mcu::timing::ms() - _startMs) < durationMs()))
+            {
+                return false;
+            }
+
+            _busy = false;
+
+            if (_request.operation == core::mcu::flash::async::operation_t::ERASE)
+            {
+                success = core::mcu::flash::erasePage(_request.address);
+            }
+            else
+            {
+                success = core::mcu::flash::write(_request.address, _request.data, _request.size) &&
+                          core::mcu::flash::flush();
+            }
+
+            return true;
+        }
+
+        bool isBusy() const
+        {
+            return _busy;
+        }
+
+        private:
+        core::mcu::flash::async::Request _request;
+        uint32_t                         _startMs = 0;
+        bool                             _busy    = false;
+
+        uint32_t durationMs() const
+        {
+            uint32_t us = core::mcu::flash::STUB_ERASE_TIME_US;
+
+            if (_request.operation == core::mcu::flash::async::operation_t::WRITE)
+            {
+                us = core::mcu::flash::STUB_PROGRAM_TIME_US * ((_request.size + core::mcu::flash::STUB_PROGRAM_PAGE_SIZE - 1) / core::mcu::flash::STUB_PROGRAM_PAGE_SIZE);
+            }
+
+            return (us + 999) / 1000;
+        }
+    };
+
+    AsyncDriver                                   _asyncDriver;
+    core::mcu::flash::async::Queue<8, AsyncDriver> _asyncQueue(_asyncDriver);
+}    // namespace
+
+namespace core::mcu::flash
+{
+    bool init()
+    {
+        // pending asynchronous operations are dropped and reported as failed
+        while (_asyncDriver.isBusy() || _asyncQueue.pending())
+        {
+            _asyncQueue.complete(false);
+            _asyncQueue.update();
+            _asyncDriver = {};
+        }
+
+        _driver.reset();
+        _cache.invalidate(0, size());
+
+        return true;
+    }
+
+    bool erasePage(size_t index)
+    {
+        if (index >= STUB_SECTORS)
+        {
+            return false;
+        }
+
+        _cache.invalidate(index * STUB_SECTOR_SIZE, STUB_SECTOR_SIZE);
+        _driver.erase(index * STUB_SECTOR_SIZE, STUB_SECTOR_SIZE);
+
+        return true;
+    }
+
+    bool write32(uint32_t address, uint32_t data)
+    {
+        return write(address, reinterpret_cast<const uint8_t*>(&data), sizeof(data));
+    }
+
+    bool write(uint32_t address, const uint8_t* data, size_t size)
+    {
+        if (!isRangeValid(address, size))
+        {
+            return false;
+        }
+
+        _cache.write(address - startAddress(), data, size);
+        return true;
+    }
+
+    bool flush()
+    {
+        _cache.flush();
+        return true;
+    }
+
+    bool read8(uint32_t address, uint8_t& data)
+    {
+        if (!isRangeValid(address, sizeof(data)))
+        {
+            return false;
+        }
+
+        _cache.read(address - startAddress(), &data, sizeof(data));
+        return true;
+    }
+
+    bool read16(uint32_t address, uint16_t& data)
+    {
+        if (!isRangeValid(address, sizeof(data)))
+        {
+            return false;
+        }
+
+        _cache.read(address - startAddress(), reinterpret_cast<uint8_t*>(&data), sizeof(data));
+        return true;
+    }
+
+    bool read32(uint32_t address, uint32_t& data)
+    {
+        if (!isRangeValid(address, sizeof(data)))
+        {
+            return false;
+        }
+
+        _cache.read(address - startAddress(), reinterpret_cast<uint8_t*>(&data), sizeof(data));
+        return true;
+    }
+
+    bool read(uint32_t address, uint8_t* data, size_t size)
+    {
+        if (!isRangeValid(address, size))
+        {
+            return false;
+        }
+
+        _cache.read(address - startAddress(), data, size);
+        return true;
+    }
+
+    stats_t stats()
+    {
+        return _driver.stats();
+    }
+
+    void resetStats()
+    {
+        _driver.stats() = {};
+    }
+
+    namespace async
+    {
+        bool erasePage(size_t index, callback_t callback, void* context)
+        {
+            if (index >= STUB_SECTORS)
+            {
+                return false;
+            }
+
+            Request request;
+
+            request.operation = operation_t::ERASE;
+            request.address   = index;
+            request.callback  = callback;
+            request.context   = context;
+
+            return _asyncQueue.push(request);
+        }
+
+        bool write(uint32_t address, const uint8_t* data, size_t size, callback_t callback, void* context)
+        {
+            if ((address % 4) || (size % 4) || (reinterpret_cast<uintptr_t>(data) % 4) || !isRangeValid(address, size))
+            {
+                return false;
+            }
+
+            Request request;
+
+            request.operation = operation_t::WRITE;
+            request.address   = address;
+            request.data      = data;
+            request.size      = size;
+            request.callback  = callback;
+            request.context   = context;
+
+            return _asyncQueue.push(request);
+        }
+
+        void update()
+        {
+            bool success = false;
+
+            if (_asyncDriver.update(success))
+            {
+                _asyncQueue.complete(success);
+            }
+
+            _asyncQueue.update();
+        }
+
+        size_t pending()
+        {
+            return _asyncQueue.pending();
+        }
+
+        bool isBusy()
+        {
+            return _asyncDriver.isBusy();
+        }
+    }    // namespace async
+}    // namespace core::mcu::flash
@@ -19,22 +19,105 @@
     OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <atomic>
 #include "core/mcu.h"
 
 namespace
 {
-    uint32_t fakeMs;
+#ifdef CORE_MCU_TIMING_TICKLESS
+    constexpr uint64_t ISR_PERIOD_TICKS = static_cast<uint64_t>(1) << core::mcu::timing::STUB_COUNTER_BITS;
+#else
+    constexpr uint64_t ISR_PERIOD_TICKS = core::mcu::timing::TICKS_PER_SECOND / 1000;
+#endif
+
+    uint64_t          fakeTicks;
+    uint32_t          fakeIsrCount;
+    uint64_t          fakeIdleTicks;
+    std::atomic<bool> wakeupRequested;    ///< Can be set from threads emulating interrupts.
+
+    void moveTo(uint64_t ticks)
+    {
+        // only the interrupts which would fire as the time moves forward are counted
+        if (ticks > fakeTicks)
+        {
+            fakeIsrCount += (ticks / ISR_PERIOD_TICKS) - (fakeTicks / ISR_PERIOD_TICKS);
+        }
+
+        fakeTicks = ticks;
+    }
 }    // namespace
 
 namespace core::mcu::timing
 {
     void setMs(uint32_t ms)
     {
-        fakeMs = ms;
+        moveTo(static_cast<uint64_t>(ms) * 1000);
+    }
+
+    void setTicks(uint64_t ticks)
+    {
+        moveTo(ticks);
+    }
+
+    void advanceUs(uint32_t us)
+    {
+        moveTo(fakeTicks + us);
     }
 
     uint32_t ms()
     {
-        return fakeMs;
+        return fakeTicks / 1000;
+    }
+
+    uint32_t us()
+    {
+        return fakeTicks;
+    }
+
+    uint64_t ticks()
+    {
+        return fakeTicks;
+    }
+
+    uint32_t isrCount()
+    {
+        return fakeIsrCount;
+    }
+
+    void resetIsrCount()
+    {
+        fakeIsrCount = 0;
+    }
+
+    uint64_t idleUs()
+    {
+        return fakeIdleTicks;
+    }
+}    // namespace core::mcu::timing
+
+namespace core::mcu
+{
+    void idle(uint32_t maxUs)
+    {
+        if (wakeupRequested.exchange(false))
+        {
+            return;
+        }
+
+        // timing interrupt is the only one simulated: it always wakes the core
+        uint64_t target = ((fakeTicks / ISR_PERIOD_TICKS) + 1) * ISR_PERIOD_TICKS;
+
+        if (maxUs && ((fakeTicks + maxUs) < target))
+        {
+            target = fakeTicks + maxUs;
+        }
+
+        fakeIdleTicks += target - fakeTicks;
+        moveTo(target);
+    }
+
+    void wake()
+    {
+        wakeupRequested = true;
     }
-}    // namespace core::mcu::timing
\ No newline at end of file
+}    // namespace core::mcu
\ No newline at end of file
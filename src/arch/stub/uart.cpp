@@ -0,0 +1,356 @@
+
+/*
+    Copyright 2017-2023 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "core/mcu.h"
+#include "core/arch/common/uart_dma.h"
+#include "core/arch/common/uart_fifo.h"
+
+using namespace core::mcu::uart;
+
+namespace
+{
+    class Fifo
+    {
+        public:
+        bool readable()
+        {
+            return _size;
+        }
+
+        uint8_t read()
+        {
+            const uint8_t DATA = _data[_head];
+            _head              = (_head + 1) % STUB_FIFO_SIZE;
+            _size--;
+
+            return DATA;
+        }
+
+        bool writable()
+        {
+            return _size < STUB_FIFO_SIZE;
+        }
+
+        void write(uint8_t data)
+        {
+            _data[(_head + _size++) % STUB_FIFO_SIZE] = data;
+        }
+
+        size_t size() const
+        {
+            return _size;
+        }
+
+        private:
+        uint8_t _data[STUB_FIFO_SIZE] = {};
+        size_t  _head                 = 0;
+        size_t  _size                 = 0;
+    };
+
+    struct channel_t
+    {
+        bool                                 initialized  = false;
+        bool                                 dma          = false;
+        Config::type_t                       type         = Config::type_t::RX_TX;
+        bool                                 transmitting = false;
+        SpanHandler                          spanHandler  = {};
+        TxSpanCursor                         txCursor     = {};
+        DmaRxBuffer<STUB_DMA_RX_BUFFER_SIZE> dmaRxBuffer  = {};
+        size_t                               dmaRxIndex   = 0;    ///< Position at which DMA writes the next byte.
+        const uint8_t*                       dmaTxData    = nullptr;
+        size_t                               dmaTxSize    = 0;
+        size_t                               dmaTxIndex   = 0;    ///< Amount of bytes DMA has sent from current block.
+        Fifo                                 rxFifo       = {};
+        Fifo                                 txFifo       = {};
+        bool                                 inIsr        = false;
+        bool                                 isrPending   = false;
+        stats_t                              stats        = {};
+    };
+
+    channel_t _channel[CORE_MCU_MAX_UART_INTERFACES];
+    bool      _fifoEnabled[CORE_MCU_MAX_UART_INTERFACES];
+
+    bool usesFifo(uint8_t channel)
+    {
+        return _fifoEnabled[channel] && !_channel[channel].dma;
+    }
+
+    /// Same as the RP2040 UART interrupt: RX FIFO is drained and TX FIFO refilled.
+    /// Interrupt raised from within the handler (eg. TX started from RX handler in loopback)
+    /// is taken once the handler returns.
+    void fifoIsr(uint8_t channel, size_t& counter)
+    {
+        auto& state = _channel[channel];
+
+        counter++;
+        state.isrPending = true;
+
+        if (state.inIsr)
+        {
+            return;
+        }
+
+        state.inIsr = true;
+
+        while (state.isrPending)
+        {
+            state.isrPending = false;
+
+            drainRxFifo<STUB_FIFO_SIZE>(state.rxFifo, state.spanHandler.received);
+
+            if (state.transmitting && !fillTxFifo(state.txFifo, state.spanHandler.next))
+            {
+                // nothing more to send: TX interrupt disabled
+                state.transmitting = false;
+            }
+        }
+
+        state.inIsr = false;
+    }
+
+    void dmaRxFlush(uint8_t channel)
+    {
+        auto& state = _channel[channel];
+
+        // remaining transfers, as reported by the DMA counter
+        state.dmaRxBuffer.update(STUB_DMA_RX_BUFFER_SIZE - state.dmaRxIndex, state.spanHandler.received);
+    }
+
+    void dmaTxNext(uint8_t channel, size_t sentBytes)
+    {
+        auto& state = _channel[channel];
+
+        state.dmaTxData    = state.spanHandler.next(sentBytes, state.dmaTxSize);
+        state.dmaTxIndex   = 0;
+        state.transmitting = state.dmaTxSize;
+    }
+}    // namespace
+
+namespace core::mcu::uart
+{
+    namespace hw
+    {
+        bool init(const Config&      config,
+                  rxHandler_t&&      rxHandler,
+                  txHandler_t&&      txHandler,
+                  const SpanHandler& spanHandler)
+        {
+            if (config.channel >= CORE_MCU_MAX_UART_INTERFACES)
+            {
+                return false;
+            }
+
+            auto& state       = _channel[config.channel];
+            state             = {};
+            state.initialized = true;
+            state.dma         = config.dma;
+            state.type        = config.type;
+            state.spanHandler = spanHandler;
+
+            return true;
+        }
+
+        bool deInit(const Config& config)
+        {
+            if (config.channel >= CORE_MCU_MAX_UART_INTERFACES)
+            {
+                return false;
+            }
+
+            _channel[config.channel] = {};
+            return true;
+        }
+
+        void startTx(const Config& config)
+        {
+            auto& state = _channel[config.channel];
+
+            if (!state.initialized || state.transmitting || (state.type == Config::type_t::RX))
+            {
+                return;
+            }
+
+            if (state.dma)
+            {
+                dmaTxNext(config.channel, 0);
+            }
+            else if (usesFifo(config.channel))
+            {
+                // TX interrupt enabled and forced
+                state.transmitting = true;
+                fifoIsr(config.channel, state.stats.txInterrupts);
+            }
+            else
+            {
+                // TX empty interrupt enabled
+                state.transmitting = true;
+            }
+        }
+    }    // namespace hw
+
+    bool receive(uint8_t channel, const uint8_t* data, size_t size)
+    {
+        if ((channel >= CORE_MCU_MAX_UART_INTERFACES) || !_channel[channel].initialized || (_channel[channel].type == Config::type_t::TX))
+        {
+            return false;
+        }
+
+        auto& state = _channel[channel];
+
+        if (usesFifo(channel))
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                // data is drained at the threshold, so the FIFO never overflows
+                state.rxFifo.write(data[i]);
+
+                if (state.rxFifo.size() == STUB_FIFO_RX_THRESHOLD)
+                {
+                    fifoIsr(channel, state.stats.rxInterrupts);
+                }
+            }
+
+            if (state.rxFifo.size())
+            {
+                // RX timeout
+                fifoIsr(channel, state.stats.rxInterrupts);
+            }
+
+            return true;
+        }
+
+        for (size_t i = 0; i < size; i++)
+        {
+            if (!state.dma)
+            {
+                state.stats.rxInterrupts++;
+                state.spanHandler.received(&data[i], 1);
+                continue;
+            }
+
+            state.dmaRxBuffer.data()[state.dmaRxIndex] = data[i];
+
+            if (++state.dmaRxIndex == STUB_DMA_RX_BUFFER_SIZE)
+            {
+                // circular mode: counter is reloaded
+                state.dmaRxIndex = 0;
+            }
+
+            if ((state.dmaRxIndex == 0) || (state.dmaRxIndex == (STUB_DMA_RX_BUFFER_SIZE / 2)))
+            {
+                // full or half transfer
+                state.stats.rxInterrupts++;
+                dmaRxFlush(channel);
+            }
+        }
+
+        if (state.dma && size)
+        {
+            // idle line
+            state.stats.rxInterrupts++;
+            dmaRxFlush(channel);
+        }
+
+        return true;
+    }
+
+    size_t transmit(uint8_t channel, uint8_t* data, size_t maxSize)
+    {
+        if (channel >= CORE_MCU_MAX_UART_INTERFACES)
+        {
+            return 0;
+        }
+
+        auto&  state = _channel[channel];
+        size_t sent  = 0;
+
+        if (usesFifo(channel))
+        {
+            while (state.txFifo.size() && (sent < maxSize))
+            {
+                data[sent++] = state.txFifo.read();
+
+                if (state.transmitting && (state.txFifo.size() == STUB_FIFO_TX_THRESHOLD))
+                {
+                    fifoIsr(channel, state.stats.txInterrupts);
+                }
+            }
+
+            return sent;
+        }
+
+        while (state.transmitting && (sent < maxSize))
+        {
+            if (state.dma)
+            {
+                data[sent++] = state.dmaTxData[state.dmaTxIndex++];
+
+                if (state.dmaTxIndex == state.dmaTxSize)
+                {
+                    // transfer complete
+                    state.stats.txInterrupts++;
+                    dmaTxNext(channel, state.dmaTxSize);
+                }
+
+                continue;
+            }
+
+            // TX empty
+            size_t  remainingBytes = 0;
+            uint8_t value          = 0;
+
+            state.stats.txInterrupts++;
+
+            if (state.txCursor.next(state.spanHandler.next, value, remainingBytes))
+            {
+                data[sent++] = value;
+            }
+            else
+            {
+                state.transmitting = false;
+            }
+        }
+
+        return sent;
+    }
+
+    void setFifoState(uint8_t channel, bool state)
+    {
+        if (channel < CORE_MCU_MAX_UART_INTERFACES)
+        {
+            _fifoEnabled[channel] = state;
+        }
+    }
+
+    stats_t stats(uint8_t channel)
+    {
+        return (channel < CORE_MCU_MAX_UART_INTERFACES) ? _channel[channel].stats : stats_t{};
+    }
+
+    void resetStats(uint8_t channel)
+    {
+        if (channel < CORE_MCU_MAX_UART_INTERFACES)
+        {
+            _channel[channel].stats = {};
+        }
+    }
+}    // namespace core::mcu::uart